@@ -39,6 +39,21 @@ if family == 'windows' then
 else
 	platform = "linux_x86_64"
 	settings.cc.flags:Add( "-Wconversion", "-Wextra", "-Wall", "-Werror", "-Wstrict-aliasing=2" )
+	settings.link.libs:Add( "pthread" )
+end
+
+-- optional content-decoding, enable with i.e. "bam zlib=true brotli=true"
+if ScriptArgs["zlib"] == "true" then
+	settings.cc.defines:Add( "HTTP_CLIENT_WITH_ZLIB" )
+	settings.link.libs:Add( family == 'windows' and "zlib" or "z" )
+end
+if ScriptArgs["brotli"] == "true" then
+	settings.cc.defines:Add( "HTTP_CLIENT_WITH_BROTLI" )
+	settings.link.libs:Add( "brotlidec" )
+end
+if ScriptArgs["zstd"] == "true" then
+	settings.cc.defines:Add( "HTTP_CLIENT_WITH_ZSTD" )
+	settings.link.libs:Add( "zstd" )
 end
 
 local output_path = PathJoin( BUILD_PATH, PathJoin( platform, config ) )
@@ -51,3 +66,7 @@ local objs  = Compile( settings, Collect( 'src/*.cpp' ) )
 local lib   = StaticLibrary( settings, 'http_client', objs )
 
 local example = Link( settings, 'http_tester',     Compile( settings, 'test/http_tester.cpp' ), lib )
+if family ~= 'windows' then
+	local bench = Link( settings, 'http_bench',      Compile( settings, 'test/http_bench.cpp' ),  lib )
+	local parse_bench = Link( settings, 'http_parse_bench', Compile( settings, 'test/http_parse_bench.cpp' ), lib )
+end
@@ -30,6 +30,7 @@
 
 #include <stdlib.h>
 #include <http_client/http_client_error.h>
+#include <http_client/http_client_headers.h>
 
 /**
  * Handle to an open http-client.
@@ -61,6 +62,20 @@ struct http_client_allocator
 	void* (*alloc)( void* ptr, size_t sz, http_client_allocator* self );
 };
 
+/**
+ * Default size of the buffer a client receive responses in, status-line and the header block of a response need to fit
+ * in it. Define before including http_client.h when building the library to change it.
+ */
+#if !defined( HTTP_CLIENT_DEFAULT_RECV_BUFFER_SIZE )
+#  define HTTP_CLIENT_DEFAULT_RECV_BUFFER_SIZE 8192
+#endif
+
+/**
+ * Max number of headers of a response returned by http_client_response_headers(), headers after that are still
+ * acted on by the client but not returned.
+ */
+#define HTTP_CLIENT_MAX_HEADERS 64
+
 /**
  * Calculate amount of memory needed to call http_client_connect if memory is allocated by the user.
  *
@@ -68,6 +83,15 @@ struct http_client_allocator
  */
 size_t http_client_calc_mem_usage( const char* url );
 
+/**
+ * Calculate amount of memory needed to call http_client_connect_ex with recv_buffer_size if memory is allocated by
+ * the user.
+ *
+ * @param url to open.
+ * @param recv_buffer_size size of receive buffer.
+ */
+size_t http_client_calc_mem_usage_ex( const char* url, size_t recv_buffer_size );
+
 /**
  * Open a http-connection to the specified url.
  *
@@ -81,10 +105,22 @@ size_t http_client_calc_mem_usage( const char* url );
  *                and be valid until after a call to http_client_disconnect().
  * @param memsize size of usermem.
  *
+ * @note the connection is kept alive between requests and transparently reconnected if the server closes it.
+ *
  * @return HTTP_CLIENT_RESULT_OK on success.
  */
 http_client_result http_client_connect( http_client_t* client, const char* url, const char* useragent, void* usermem, size_t memsize );
 
+/**
+ * Open a http-connection to the specified url as http_client_connect() but with a receive buffer of recv_buffer_size
+ * bytes instead of HTTP_CLIENT_DEFAULT_RECV_BUFFER_SIZE, for servers sending long header lines.
+ *
+ * @note usermem, if used, must be at least http_client_calc_mem_usage_ex( url, recv_buffer_size ) bytes.
+ *
+ * @return HTTP_CLIENT_RESULT_OK on success, HTTP_CLIENT_BUFFER_TOO_SMALL if recv_buffer_size is below 256 bytes.
+ */
+http_client_result http_client_connect_ex( http_client_t* client, const char* url, const char* useragent, size_t recv_buffer_size, void* usermem, size_t memsize );
+
 /**
  * Disconnect a connected client from host.
  *
@@ -92,6 +128,199 @@ http_client_result http_client_connect( http_client_t* client, const char* url,
  */
 void http_client_disconnect( http_client_t client );
 
+/**
+ * A response header, name and value are '\0'-terminated and the value has leading and trailing whitespace removed.
+ */
+struct http_client_header
+{
+	const char* name;
+	size_t      name_len;
+	const char* value;
+	size_t      value_len;
+};
+
+/**
+ * Get the headers of the last response received by client, in the order they were received.
+ *
+ * @note headers point into the receive buffer of client and are valid until the next request is made on client.
+ *
+ * @param client client to get headers from.
+ * @param headers set to the headers.
+ *
+ * @return number of headers.
+ */
+size_t http_client_response_headers( http_client_t client, const http_client_header** headers );
+
+/**
+ * Get a well-known header of the last response received by client, constant time. If the header occurs more than once
+ * the first one is returned.
+ *
+ * @note the returned header is valid until the next request is made on client.
+ *
+ * @return the header or NULL if not received.
+ */
+const http_client_header* http_client_get_header( http_client_t client, http_client_header_id id );
+
+/**
+ * Find a header of the last response received by client by name, case-insensitive. If the header occurs more than
+ * once the first one is returned.
+ *
+ * @note the returned header is valid until the next request is made on client.
+ *
+ * @return the header or NULL if not found.
+ */
+const http_client_header* http_client_find_header( http_client_t client, const char* name );
+
+/**
+ * Events reported to http_client_hooks::connection.
+ */
+enum http_client_connection_event
+{
+	HTTP_CLIENT_CONNECTION_OPENED, ///< a new connection was established.
+	HTTP_CLIENT_CONNECTION_REUSED, ///< a kept-alive connection is used for a request.
+	HTTP_CLIENT_CONNECTION_CLOSED  ///< a connection was closed by the client.
+};
+
+/**
+ * Hooks called as a client processes requests, for tracing and logging. All hooks are optional and called on the
+ * thread making the call on the client.
+ *
+ * Hooks can be compiled out of the library completely by building it with HTTP_CLIENT_DISABLE_HOOKS defined.
+ */
+struct http_client_hooks
+{
+	/**
+	 * Called when a request is started, for pipelined requests when each request is sent.
+	 */
+	void (*request_start)( const char* verb, const char* resource, void* userdata );
+
+	/**
+	 * Called with the status of each received response, including informational 1xx responses.
+	 */
+	void (*status)( unsigned int status, void* userdata );
+
+	/**
+	 * Called for each received header, name and value are not '\0'-terminated.
+	 */
+	void (*header)( const char* name, size_t name_len, const char* value, size_t value_len, void* userdata );
+
+	/**
+	 * Called with each received part of a response body, also for bodies of failed requests that are discarded.
+	 */
+	void (*body_chunk)( const void* data, size_t size, void* userdata );
+
+	/**
+	 * Called when a request fails for other reasons than the status returned by the server.
+	 */
+	void (*error)( http_client_result error, void* userdata );
+
+	/**
+	 * Called when a connection is opened, reused or closed.
+	 */
+	void (*connection)( http_client_connection_event event, void* userdata );
+};
+
+/**
+ * Set hooks to call on client.
+ *
+ * @param client client to set hooks on.
+ * @param hooks hooks to call, can be NULL to remove all hooks. Needs to be valid as long as it is set on client.
+ * @param userdata passed to all hooks.
+ */
+void http_client_set_hooks( http_client_t client, const http_client_hooks* hooks, void* userdata );
+
+/**
+ * Where time went during the last call on a client, see http_client_get_stats().
+ *
+ * Timestamps are from a monotonic clock in microseconds, a timestamp of 0 means that the phase did not happen during
+ * the call, i.e. dns_done and connect_done are 0 if a kept-alive connection was reused.
+ */
+struct http_client_stats
+{
+	unsigned long long start;        ///< call started.
+	unsigned long long dns_done;     ///< host name resolved.
+	unsigned long long connect_done; ///< tcp connection established.
+	unsigned long long request_sent; ///< request, including body, written to the socket.
+	unsigned long long first_byte;   ///< first byte of the response received.
+	unsigned long long headers_done; ///< status-line and headers received.
+	unsigned long long body_done;    ///< body received, i.e. the call is done.
+
+	size_t bytes_sent;
+	size_t bytes_received;
+	unsigned int send_calls; ///< number of send-syscalls, sendmsg(), sendfile() or WSASend().
+	unsigned int recv_calls; ///< number of recv-syscalls.
+	unsigned int retries;    ///< number of times the request was resent after a kept-alive connection turned out to be closed.
+};
+
+/**
+ * Get stats of the last call made on client. For http_client_pipeline() the stats cover the whole batch, first_byte
+ * being that of the first response and headers_done that of the last.
+ *
+ * @param client client to get stats for.
+ * @param stats filled with stats.
+ */
+void http_client_get_stats( http_client_t client, http_client_stats* stats );
+
+/**
+ * Timeouts used by a client, all in ms.
+ *
+ * When a host resolves to multiple addresses they are raced as in "Happy Eyeballs" (rfc 8305), a new attempt is
+ * started each connect_attempt_delay ms, or as soon as an attempt fails, until one connects. Addresses are tried
+ * alternating between ipv6 and ipv4.
+ *
+ * request is an absolute deadline for each call on the client, i.e. http_client_get(), covering connecting, sending
+ * the request and receiving the whole response. It fails with the timeout of the phase the call was in when it
+ * expired.
+ */
+struct http_client_timeouts
+{
+	unsigned int connect_attempt_delay; ///< delay before starting the next connect attempt in parallel, 0 for the default of 250.
+	unsigned int connect_attempt;       ///< time before a single connect attempt is abandoned, 0 to only be limited by connect.
+	unsigned int connect;               ///< time before connecting is abandoned with HTTP_CLIENT_CONNECT_TIMEOUT, 0 for no limit.
+	unsigned int read;                  ///< max time to wait for data from the server, HTTP_CLIENT_READ_TIMEOUT if exceeded. 0 for no limit.
+	unsigned int write;                 ///< max time to wait for the server to accept data, HTTP_CLIENT_WRITE_TIMEOUT if exceeded. 0 for no limit.
+	unsigned int request;               ///< deadline of each call, 0 for no limit.
+};
+
+/**
+ * Set timeouts used by clients connected and multi-engines created after this call, NULL to reset to the defaults.
+ * Not thread-safe, set before any client is connected.
+ */
+void http_client_set_default_timeouts( const http_client_timeouts* timeouts );
+
+/**
+ * Set timeouts of client, used from the next call.
+ *
+ * @param client client to set timeouts on.
+ * @param timeouts timeouts to use, NULL to use the defaults.
+ */
+void http_client_set_timeouts( http_client_t client, const http_client_timeouts* timeouts );
+
+/**
+ * Content-codings a client can decompress.
+ */
+enum http_client_encoding
+{
+	HTTP_CLIENT_ENCODING_GZIP    = 1 << 0, ///< requires the library to be built with HTTP_CLIENT_WITH_ZLIB.
+	HTTP_CLIENT_ENCODING_DEFLATE = 1 << 1, ///< requires the library to be built with HTTP_CLIENT_WITH_ZLIB.
+	HTTP_CLIENT_ENCODING_BROTLI  = 1 << 2, ///< requires the library to be built with HTTP_CLIENT_WITH_BROTLI.
+	HTTP_CLIENT_ENCODING_ZSTD    = 1 << 3, ///< requires the library to be built with HTTP_CLIENT_WITH_ZSTD.
+};
+
+/**
+ * Request compressed responses and decompress them transparently while they are received. Requests sent by client
+ * will carry an Accept-Encoding header listing the enabled codings and response bodies encoded with one of them are
+ * passed decompressed to the body-sink or callback of the call. Decompression is off by default.
+ *
+ * @param client client to enable decompression on.
+ * @param encodings HTTP_CLIENT_ENCODING_*-flags to enable, 0 to disable decompression.
+ *
+ * @return the subset of encodings that was enabled, codings the library is not built with are ignored.
+ *
+ * @note body_chunk-hooks sees the body as it was received, i.e. still compressed.
+ */
+unsigned int http_client_set_decompression( http_client_t client, unsigned int encodings );
+
 /**
  * Perform http GET request towards connected host.
  *
@@ -107,6 +336,43 @@ void http_client_disconnect( http_client_t client );
  */
 http_client_result http_client_get( http_client_t client, const char* resource, void** msgbody, size_t* msgbody_size, http_client_allocator* alloc );
 
+/**
+ * Perform http GET request towards connected host and receive the message body directly into a user-provided buffer.
+ *
+ * @param client connected client.
+ * @param resource resource on server to GET ( host.com/this/is/the/resource.htm -> /this/is/the/resource.htm )
+ * @param buffer buffer to receive message body into.
+ * @param buffer_size size of buffer.
+ * @param msgbody_size ptr where to return GET message body size.
+ *
+ * @return HTTP_CLIENT_OK on success, HTTP_CLIENT_BUFFER_TOO_SMALL if the message body do not fit in buffer.
+ */
+http_client_result http_client_get_into( http_client_t client, const char* resource, void* buffer, size_t buffer_size, size_t* msgbody_size );
+
+/**
+ * Callback receiving parts of a message body.
+ *
+ * @param data part of message body, only valid during the callback.
+ * @param size size of data.
+ * @param userdata userdata passed to the function performing the request.
+ *
+ * @return 0 to continue or non-zero to abort the request.
+ */
+typedef int (*http_client_body_callback)( const void* data, size_t size, void* userdata );
+
+/**
+ * Perform http GET request towards connected host and pass the message body to callback as it is received,
+ * no memory is allocated for the body.
+ *
+ * @param client connected client.
+ * @param resource resource on server to GET ( host.com/this/is/the/resource.htm -> /this/is/the/resource.htm )
+ * @param callback called with each received part of the message body, in order.
+ * @param userdata passed to callback.
+ *
+ * @return HTTP_CLIENT_OK on success, HTTP_CLIENT_ABORTED if callback aborted the request.
+ */
+http_client_result http_client_get_stream( http_client_t client, const char* resource, http_client_body_callback callback, void* userdata );
+
 /**
  * Perform http HEAD request towards connected host.
  *
@@ -142,6 +408,59 @@ http_client_result http_client_post( http_client_t client, const char* resource,
  */
 http_client_result http_client_put( http_client_t client, const char* resource, const void* msgbody, size_t msgbody_size );
 
+/**
+ * Perform http POST request towards connected host with the body read from a file.
+ *
+ * The body is sent with sendfile() where supported so that the file content never needs to be copied to user memory,
+ * otherwise the file is read and sent in parts.
+ *
+ * @param client connected client.
+ * @param resource resource on server to POST ( host.com/this/is/the/resource.htm -> /this/is/the/resource.htm )
+ * @param fd file descriptor to read body from, needs to support positioned reads.
+ * @param offset offset in file where body starts.
+ * @param size size of body in bytes.
+ *
+ * @return HTTP_CLIENT_OK on success, HTTP_CLIENT_FILE_ERROR if fd could not be read.
+ */
+http_client_result http_client_post_file( http_client_t client, const char* resource, int fd, size_t offset, size_t size );
+
+/**
+ * Perform http PUT request towards connected host with the body read from a file, see http_client_post_file().
+ */
+http_client_result http_client_put_file( http_client_t client, const char* resource, int fd, size_t offset, size_t size );
+
+/**
+ * Callback producing the message body of a chunked upload.
+ *
+ * @param buffer buffer to write the next part of the body to.
+ * @param buffer_size size of buffer.
+ * @param produced set to number of bytes written to buffer, 0 marks the end of the body.
+ * @param userdata userdata passed to http_client_post_chunked() or http_client_put_chunked().
+ *
+ * @return 0 to continue, any other value aborts the request.
+ */
+typedef int (*http_client_body_producer)( void* buffer, size_t buffer_size, size_t* produced, void* userdata );
+
+/**
+ * Perform http POST request towards connected host with the body sent with "Transfer-Encoding: chunked" as it is
+ * pulled from producer. Useful when the size of the body is not known up front.
+ *
+ * @note as the body can not be replayed the request is not retried if a kept-alive connection turns out to be closed.
+ *
+ * @param client connected client.
+ * @param resource resource on server to POST ( host.com/this/is/the/resource.htm -> /this/is/the/resource.htm )
+ * @param producer called repeatedly to get the body until it produces 0 bytes.
+ * @param userdata passed to producer.
+ *
+ * @return HTTP_CLIENT_OK on success, HTTP_CLIENT_ABORTED if producer aborted the request.
+ */
+http_client_result http_client_post_chunked( http_client_t client, const char* resource, http_client_body_producer producer, void* userdata );
+
+/**
+ * Perform http PUT request towards connected host with the body pulled from producer, see http_client_post_chunked().
+ */
+http_client_result http_client_put_chunked( http_client_t client, const char* resource, http_client_body_producer producer, void* userdata );
+
 /**
  * Perform http DELETE request towards connected host.
  *
@@ -152,6 +471,35 @@ http_client_result http_client_put( http_client_t client, const char* resource,
  */
 http_client_result http_client_delete( http_client_t client, const char* resource );
 
+/**
+ * Request to perform with http_client_pipeline().
+ */
+struct http_client_pipeline_request
+{
+	const char* verb;          ///< "GET" or "HEAD".
+	const char* resource;      ///< resource on server, same as for http_client_get().
+	void* msgbody;             ///< set to message body of a GET, allocated as in http_client_get().
+	size_t msgbody_size;       ///< set to size of msgbody or resource size for a HEAD.
+	http_client_result result; ///< set to result of this request.
+};
+
+/**
+ * Perform multiple GET/HEAD requests pipelined on the connection, requests are written back-to-back and the responses
+ * read in order, saving a round-trip per request.
+ *
+ * If the server closes the connection mid-pipeline the requests that got no response are retried one at a time.
+ *
+ * @param client connected client.
+ * @param requests requests to perform, result is reported in each request.
+ * @param num_requests number of items in requests.
+ * @param alloc allocator to use to alloc msgbody or NULL to use malloc.
+ *
+ * @note memory allocated for msgbody will need to be free:ed manually even if an error occured.
+ *
+ * @return HTTP_CLIENT_OK if all requests succeeded, otherwise the result of the first request that failed.
+ */
+http_client_result http_client_pipeline( http_client_t client, http_client_pipeline_request* requests, size_t num_requests, http_client_allocator* alloc );
+
 /**
  * Convert http_client_result to string.
  */
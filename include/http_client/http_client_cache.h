@@ -0,0 +1,122 @@
+/*
+    Simple http-client written to be an drop-in code, focus is to be small
+    and easy to use but maybe not efficient.
+
+    version 1.0, June, 2014
+
+	Copyright (C) 2014- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+#ifndef HTTP_CLIENT_CACHE_H_INCLUDED
+#define HTTP_CLIENT_CACHE_H_INCLUDED
+
+#include <http_client/http_client.h>
+
+/**
+ * Handle to a response cache, an in-memory cache of GET responses that can be shared by clients and pools.
+ *
+ * Responses are stored if the server allows it, i.e. not "Cache-Control: no-store", and are served without touching
+ * the network for as long as they are fresh according to "Cache-Control: max-age" or "Expires". Stale responses
+ * with an ETag or Last-Modified are revalidated with If-None-Match/If-Modified-Since and a "304 Not Modified" is
+ * served from the cache. Responses with neither a freshness lifetime nor a validator are not stored.
+ *
+ * Only 200 responses to GET without "Vary" (other than on Accept-Encoding) are stored, and a successful request
+ * with any other method than GET and HEAD drops the cached response for its resource. Bodies are stored as passed
+ * to the caller, i.e. after decompression.
+ *
+ * With a path in the config responses are stored in memory-mapped files instead of in memory, the data file is
+ * created with a size of max_bytes and is used as a ring where the oldest records are overwritten, records read
+ * shortly before they would be overwritten are moved to the front. Opening the cache only maps the index, and hits
+ * are passed to the caller directly from the mapping, i.e. a http_client_get_stream() callback gets a pointer into
+ * the mapped file. The files may only be used by one process at a time, and this is not supported on windows.
+ *
+ * @example
+ *
+ * http_client_cache_t cache;
+ * http_client_cache_create( &cache, 0x0 );
+ * http_client_set_cache( client, cache );
+ *
+ * // ... a second GET of a fresh resource is now served from memory ...
+ * http_client_get( client, "/config.json", &body, &body_size, 0x0 );
+ *
+ * http_client_disconnect( client );
+ * http_client_cache_destroy( cache );
+ */
+typedef struct http_client_cache* http_client_cache_t;
+
+/**
+ * Configuration used when creating a cache, 0 for any value use the default.
+ */
+struct http_client_cache_config
+{
+	size_t max_bytes;      ///< max total size of cached responses, least recently used are evicted first. Defaults to 16MB.
+	size_t max_entry_size; ///< responses with larger bodies are not stored, defaults to max_bytes / 8.
+	const char* path;      ///< store responses on disk, in "<path>.idx" and "<path>.dat", to keep them across restarts. NULL to only keep them in memory.
+};
+
+/**
+ * Counters reported by http_client_cache_get_stats().
+ */
+struct http_client_cache_stats
+{
+	unsigned long long hits;        ///< GETs served from the cache without a request.
+	unsigned long long stale;       ///< GETs that found a stale response and sent a conditional request.
+	unsigned long long revalidated; ///< conditional requests answered with "304 Not Modified" and served from the cache.
+	unsigned long long misses;      ///< GETs of resources not in the cache.
+	unsigned long long stores;      ///< responses stored.
+	unsigned long long evicted;     ///< responses evicted to stay within max_bytes.
+	unsigned int       entries;     ///< responses currently in the cache.
+	size_t             bytes;       ///< bytes currently used by cached responses.
+};
+
+/**
+ * Create a new response cache.
+ *
+ * @param cache ptr to http_client_cache_t to fill.
+ * @param config configuration, can be NULL for defaults.
+ *
+ * @return HTTP_CLIENT_OK on success, HTTP_CLIENT_FILE_ERROR if the files at path could not be opened or are used by
+ *         another process.
+ */
+http_client_result http_client_cache_create( http_client_cache_t* cache, const http_client_cache_config* config );
+
+/**
+ * Destroy cache. No client or pool may use the cache after this call.
+ */
+void http_client_cache_destroy( http_client_cache_t cache );
+
+/**
+ * Set the cache used by GETs on client, NULL to not use a cache. The cache is thread-safe and can be shared by clients
+ * used by different threads.
+ */
+void http_client_set_cache( http_client_t client, http_client_cache_t cache );
+
+/**
+ * Drop all cached responses.
+ */
+void http_client_cache_flush( http_client_cache_t cache );
+
+/**
+ * Get cache counters.
+ */
+void http_client_cache_get_stats( http_client_cache_t cache, http_client_cache_stats* stats );
+
+#endif // HTTP_CLIENT_CACHE_H_INCLUDED
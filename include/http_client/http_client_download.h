@@ -0,0 +1,107 @@
+/*
+    Simple http-client written to be an drop-in code, focus is to be small
+    and easy to use but maybe not efficient.
+
+    version 1.0, June, 2014
+
+	Copyright (C) 2014- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+#ifndef HTTP_CLIENT_DOWNLOAD_H_INCLUDED
+#define HTTP_CLIENT_DOWNLOAD_H_INCLUDED
+
+#include <http_client/http_client.h>
+
+/**
+ * Download of large resources as byte ranges fetched in parallel over multiple connections.
+ *
+ * The size of the resource is found with a HEAD. If the server accepts ranges the body is split into segments of
+ * segment_size that are fetched with "Range"-requests on up to connections connections to the host of client, each
+ * segment written directly to its offset in the output. client is used as one of the connections, the others are
+ * connected when the download starts and closed when it is done. Segments are requested with "If-Range" and the
+ * validator of the HEAD, so a resource that is changed during the download is never mixed with the old one.
+ *
+ * If the server does not advertise "Accept-Ranges: bytes", the size is unknown or the body is no larger than one
+ * segment it is fetched with a single GET on client. The same is done if the server answers a range request with
+ * anything but the requested range, i.e. a 200 with the full body.
+ *
+ * Requests are not served from or stored in the response cache, the timeouts of client apply to each request and
+ * hooks of client are only called for requests made on client itself.
+ *
+ * http_client_download_resume() instead downloads on client alone, to a file that a failed download can later be
+ * continued in.
+ *
+ * @example
+ *
+ * http_client_download_config config = { 8, 4 * 1024 * 1024 };
+ * http_client_download_file( client, "/big.iso", &config, fd, &size );
+ */
+
+/**
+ * Configuration of a download, 0 for any value use the default.
+ */
+struct http_client_download_config
+{
+	unsigned int connections; ///< max number of connections to use, including client. Defaults to 4.
+	size_t segment_size;      ///< size of each requested range. Defaults to 1MB.
+};
+
+/**
+ * Download resource to buffer.
+ *
+ * @param client client connected to the host to download from.
+ * @param resource resource to download.
+ * @param config download configuration, can be NULL for defaults.
+ * @param buffer buffer to receive body into.
+ * @param buffer_size size of buffer.
+ * @param msgbody_size ptr where to return the size of the body.
+ *
+ * @return HTTP_CLIENT_OK on success, HTTP_CLIENT_BUFFER_TOO_SMALL if the body does not fit in buffer.
+ */
+http_client_result http_client_download( http_client_t client, const char* resource, const http_client_download_config* config, void* buffer, size_t buffer_size, size_t* msgbody_size );
+
+/**
+ * Download resource to file fd, starting at offset 0. fd needs to be opened for writing and is not truncated.
+ *
+ * @return HTTP_CLIENT_OK on success, HTTP_CLIENT_FILE_ERROR if fd could not be written.
+ */
+http_client_result http_client_download_file( http_client_t client, const char* resource, const http_client_download_config* config, int fd, size_t* msgbody_size );
+
+/**
+ * Download resource to the file at path, continuing an earlier attempt to download it to the same path that failed.
+ *
+ * Progress is recorded in the journal "<path>.journal" together with the ETag or Last-Modified of the body. If a
+ * journal is found the download continues with "Range: bytes=<n>-" and "If-Range" from where the journal says the
+ * file ends, if the resource has changed since the server sends it all and the file is overwritten. The journal is
+ * only updated after the file has been synced, every few MB and when a download fails, and is removed when the
+ * download completes. The body is requested without content-coding as a compressed body can not be resumed.
+ *
+ * @param client client connected to the host to download from.
+ * @param resource resource to download.
+ * @param path file to download to, created if it does not exist.
+ * @param msgbody_size ptr where to return the size of the body.
+ *
+ * @return HTTP_CLIENT_OK on success, HTTP_CLIENT_FILE_ERROR if path or its journal could not be opened or written.
+ *         On any other error the download can be continued by calling this again.
+ */
+http_client_result http_client_download_resume( http_client_t client, const char* resource, const char* path, size_t* msgbody_size );
+
+#endif // HTTP_CLIENT_DOWNLOAD_H_INCLUDED
@@ -43,6 +43,15 @@ enum http_client_result
 	HTTP_CLIENT_CONNECTION_LOST,
 	HTTP_CLIENT_MEMORY_ALLOC_ERROR,
 	HTTP_CLIENT_INTERNAL_ERROR,
+	HTTP_CLIENT_POOL_EXHAUSTED, ///< connection-pool has reached its limit of connections to the host.
+	HTTP_CLIENT_NOT_SUPPORTED,  ///< functionality is not supported on this platform.
+	HTTP_CLIENT_ABORTED,        ///< request was aborted by a user callback.
+	HTTP_CLIENT_BUFFER_TOO_SMALL, ///< data did not fit in the buffer it was to be received into.
+	HTTP_CLIENT_FILE_ERROR,     ///< failed to read or write a file.
+	HTTP_CLIENT_CONNECT_TIMEOUT, ///< no connection could be established within the connect timeout.
+	HTTP_CLIENT_READ_TIMEOUT,   ///< no data was received within the read timeout, or the request deadline expired while receiving.
+	HTTP_CLIENT_WRITE_TIMEOUT,  ///< no data could be sent within the write timeout, or the request deadline expired while sending.
+	HTTP_CLIENT_DECODE_ERROR,   ///< a content-coded response body could not be decompressed.
 
 	// will I need these error-codes, or should re-direct be handled internally?
 	HTTP_CLIENT_RESULT_300_MULTIPLE_CHOICES = 300,
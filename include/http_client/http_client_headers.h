@@ -0,0 +1,85 @@
+/*
+    Simple http-client written to be an drop-in code, focus is to be small
+    and easy to use but maybe not efficient.
+
+    version 1.0, June, 2014
+
+	Copyright (C) 2014- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+// generated by tools/gen_header_hash.py, do not edit.
+
+#ifndef HTTP_CLIENT_HEADERS_H_INCLUDED
+#define HTTP_CLIENT_HEADERS_H_INCLUDED
+
+/**
+ * Well-known response headers, see http_client_get_header().
+ */
+enum http_client_header_id
+{
+	HTTP_CLIENT_HEADER_ACCEPT_RANGES,
+	HTTP_CLIENT_HEADER_ACCESS_CONTROL_ALLOW_CREDENTIALS,
+	HTTP_CLIENT_HEADER_ACCESS_CONTROL_ALLOW_HEADERS,
+	HTTP_CLIENT_HEADER_ACCESS_CONTROL_ALLOW_METHODS,
+	HTTP_CLIENT_HEADER_ACCESS_CONTROL_ALLOW_ORIGIN,
+	HTTP_CLIENT_HEADER_ACCESS_CONTROL_EXPOSE_HEADERS,
+	HTTP_CLIENT_HEADER_ACCESS_CONTROL_MAX_AGE,
+	HTTP_CLIENT_HEADER_AGE,
+	HTTP_CLIENT_HEADER_ALLOW,
+	HTTP_CLIENT_HEADER_ALT_SVC,
+	HTTP_CLIENT_HEADER_CACHE_CONTROL,
+	HTTP_CLIENT_HEADER_CONNECTION,
+	HTTP_CLIENT_HEADER_CONTENT_DISPOSITION,
+	HTTP_CLIENT_HEADER_CONTENT_ENCODING,
+	HTTP_CLIENT_HEADER_CONTENT_LANGUAGE,
+	HTTP_CLIENT_HEADER_CONTENT_LENGTH,
+	HTTP_CLIENT_HEADER_CONTENT_LOCATION,
+	HTTP_CLIENT_HEADER_CONTENT_RANGE,
+	HTTP_CLIENT_HEADER_CONTENT_SECURITY_POLICY,
+	HTTP_CLIENT_HEADER_CONTENT_TYPE,
+	HTTP_CLIENT_HEADER_DATE,
+	HTTP_CLIENT_HEADER_ETAG,
+	HTTP_CLIENT_HEADER_EXPIRES,
+	HTTP_CLIENT_HEADER_KEEP_ALIVE,
+	HTTP_CLIENT_HEADER_LAST_MODIFIED,
+	HTTP_CLIENT_HEADER_LINK,
+	HTTP_CLIENT_HEADER_LOCATION,
+	HTTP_CLIENT_HEADER_PRAGMA,
+	HTTP_CLIENT_HEADER_PROXY_AUTHENTICATE,
+	HTTP_CLIENT_HEADER_RETRY_AFTER,
+	HTTP_CLIENT_HEADER_SERVER,
+	HTTP_CLIENT_HEADER_SET_COOKIE,
+	HTTP_CLIENT_HEADER_STRICT_TRANSPORT_SECURITY,
+	HTTP_CLIENT_HEADER_TRAILER,
+	HTTP_CLIENT_HEADER_TRANSFER_ENCODING,
+	HTTP_CLIENT_HEADER_UPGRADE,
+	HTTP_CLIENT_HEADER_VARY,
+	HTTP_CLIENT_HEADER_VIA,
+	HTTP_CLIENT_HEADER_WARNING,
+	HTTP_CLIENT_HEADER_WWW_AUTHENTICATE,
+	HTTP_CLIENT_HEADER_X_CONTENT_TYPE_OPTIONS,
+	HTTP_CLIENT_HEADER_X_FRAME_OPTIONS,
+
+	HTTP_CLIENT_HEADER_KNOWN_COUNT,
+	HTTP_CLIENT_HEADER_UNKNOWN = HTTP_CLIENT_HEADER_KNOWN_COUNT ///< header is not one of the known ones.
+};
+
+#endif // HTTP_CLIENT_HEADERS_H_INCLUDED
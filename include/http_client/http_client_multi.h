@@ -0,0 +1,130 @@
+/*
+    Simple http-client written to be an drop-in code, focus is to be small
+    and easy to use but maybe not efficient.
+
+    version 1.0, June, 2014
+
+	Copyright (C) 2014- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+#ifndef HTTP_CLIENT_MULTI_H_INCLUDED
+#define HTTP_CLIENT_MULTI_H_INCLUDED
+
+#include <http_client/http_client.h>
+#include <http_client/http_client_resolver.h>
+
+/**
+ * Handle to an engine running many requests concurrently on non-blocking connections from one thread.
+ *
+ * Requests are queued with http_client_multi_add() and all I/O is done in http_client_multi_run(), each
+ * request is completed by calling its callback from within http_client_multi_run().
+ *
+ * @note only supported on linux (epoll), http_client_multi_create() returns HTTP_CLIENT_NOT_SUPPORTED elsewhere.
+ *
+ * @example
+ *
+ * http_client_multi_t multi;
+ * http_client_multi_create( &multi, 0x0 );
+ * http_client_multi_add( multi, "GET", "http://example.com", "/index.html", 0x0, 0, my_callback, &my_data );
+ * while( http_client_multi_run( multi, 100 ) > 0 )
+ *     ;
+ * http_client_multi_destroy( multi );
+ */
+typedef struct http_client_multi* http_client_multi_t;
+
+/**
+ * Callback called when a request added to a http_client_multi_t is completed.
+ *
+ * @param result HTTP_CLIENT_OK on success, otherwise an error or http-status code.
+ * @param body message body of the response, only valid during the callback.
+ * @param body_size size of body.
+ * @param userdata userdata passed to http_client_multi_add().
+ */
+typedef void (*http_client_multi_callback)( http_client_result result, const void* body, size_t body_size, void* userdata );
+
+/**
+ * Configuration used when creating a multi-engine.
+ *
+ * Timeouts work as for a single client with the following differences. The addresses of a host are tried one after
+ * the other, so connect_attempt_delay and connect_attempt are not used. request is counted from
+ * http_client_multi_add(), including time spent queued when max_per_host is reached. An expired request is completed
+ * with the timeout of the phase it was in and its connection is closed.
+ */
+struct http_client_multi_config
+{
+	unsigned int max_per_host;     ///< max number of connections per scheme/host/port, requests are queued when reached. 0 for no limit.
+	const char* useragent;         ///< user agent to identify as, can be NULL to use "http-client". Needs to be valid during the lifetime of the engine.
+	http_client_allocator* alloc;  ///< allocator used for response bodies, can be NULL to use malloc.
+	http_client_resolver_t resolver; ///< resolver to look up hosts through without blocking, can be NULL to use the default resolver. If neither is set lookups block the engine.
+	const http_client_timeouts* timeouts; ///< timeouts of each request, can be NULL to use the ones set with http_client_set_default_timeouts(). See below.
+};
+
+/**
+ * Create a new multi-engine.
+ *
+ * @param multi ptr to http_client_multi_t to fill.
+ * @param config configuration, can be NULL for defaults.
+ *
+ * @return HTTP_CLIENT_OK on success.
+ */
+http_client_result http_client_multi_create( http_client_multi_t* multi, const http_client_multi_config* config );
+
+/**
+ * Destroy engine, all requests not yet completed will be completed with HTTP_CLIENT_CONNECTION_LOST.
+ */
+void http_client_multi_destroy( http_client_multi_t multi );
+
+/**
+ * Queue a request, it will be started by the next call to http_client_multi_run().
+ * It is valid to call this from within a callback.
+ *
+ * @param multi engine to add request to.
+ * @param verb http verb, "GET", "HEAD", "POST", "PUT" or "DELETE".
+ * @param url url of host to send request to, same as for http_client_connect().
+ * @param resource resource on server ( host.com/this/is/the/resource.htm -> /this/is/the/resource.htm )
+ * @param payload body of request or NULL. Needs to be valid until the request is completed.
+ * @param payload_size size of payload.
+ * @param callback function to call when request is completed.
+ * @param userdata passed to callback.
+ *
+ * @return HTTP_CLIENT_OK on success.
+ */
+http_client_result http_client_multi_add( http_client_multi_t multi,
+										  const char* verb,
+										  const char* url,
+										  const char* resource,
+										  const void* payload,
+										  size_t payload_size,
+										  http_client_multi_callback callback,
+										  void* userdata );
+
+/**
+ * Wait up to timeout ms for I/O on any connection and process all requests that can make progress.
+ *
+ * @param multi engine to run.
+ * @param timeout max time to wait for I/O in ms, 0 to not wait and -1 to wait until anything happens. Waiting is cut
+ *                short when the timeout of any request expires.
+ *
+ * @return number of requests not yet completed.
+ */
+unsigned int http_client_multi_run( http_client_multi_t multi, int timeout );
+
+#endif // HTTP_CLIENT_MULTI_H_INCLUDED
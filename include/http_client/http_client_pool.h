@@ -0,0 +1,110 @@
+/*
+    Simple http-client written to be an drop-in code, focus is to be small
+    and easy to use but maybe not efficient.
+
+    version 1.0, June, 2014
+
+	Copyright (C) 2014- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+#ifndef HTTP_CLIENT_POOL_H_INCLUDED
+#define HTTP_CLIENT_POOL_H_INCLUDED
+
+#include <http_client/http_client.h>
+#include <http_client/http_client_cache.h>
+
+/**
+ * Handle to a pool of keep-alive connections.
+ *
+ * Connections are keyed by scheme/host/port and can be shared by multiple threads, each thread leasing a
+ * connection with http_client_pool_acquire() and returning it with http_client_pool_release().
+ */
+typedef struct http_client_pool* http_client_pool_t;
+
+/**
+ * Configuration used when creating a pool.
+ */
+struct http_client_pool_config
+{
+	unsigned int max_per_host; ///< max number of connections, leased or idle, per scheme/host/port. 0 for no limit.
+	unsigned int idle_timeout; ///< idle connections older than this many ms are closed, 0 to never evict.
+	const char*  useragent;    ///< user agent to use for connections, can be NULL. Needs to be valid during the lifetime of the pool.
+	size_t       recv_buffer_size; ///< size of receive buffer of each connection, 0 for HTTP_CLIENT_DEFAULT_RECV_BUFFER_SIZE.
+	http_client_cache_t cache;     ///< response cache used by all connections, can be NULL. Needs to be valid during the lifetime of the pool.
+};
+
+/**
+ * Counters reported by http_client_pool_get_stats().
+ */
+struct http_client_pool_stats
+{
+	unsigned long long hits;    ///< acquires that got an idle connection.
+	unsigned long long misses;  ///< acquires that needed to create a new connection.
+	unsigned long long evicted; ///< idle connections closed because of idle_timeout.
+	unsigned long long dead;    ///< idle connections found to be closed by the server when acquired.
+	unsigned int leased;        ///< connections currently leased.
+	unsigned int idle;          ///< connections currently idle in the pool.
+};
+
+/**
+ * Create a new connection pool.
+ *
+ * @param pool ptr to http_client_pool_t to fill.
+ * @param config pool configuration, can be NULL for defaults, no limit and no idle timeout.
+ *
+ * @return HTTP_CLIENT_OK on success.
+ */
+http_client_result http_client_pool_create( http_client_pool_t* pool, const http_client_pool_config* config );
+
+/**
+ * Close all idle connections and destroy the pool. All leased connections need to be released before this call.
+ */
+void http_client_pool_destroy( http_client_pool_t pool );
+
+/**
+ * Lease a connection to host in url, an idle connection is reused if available otherwise a new one is connected.
+ *
+ * @param pool pool to lease from.
+ * @param url url to connect to, only scheme, host and port is used to find a connection.
+ * @param client ptr where to return leased client.
+ *
+ * @return HTTP_CLIENT_OK on success, HTTP_CLIENT_POOL_EXHAUSTED if max_per_host connections are already leased.
+ */
+http_client_result http_client_pool_acquire( http_client_pool_t pool, const char* url, http_client_t* client );
+
+/**
+ * Return a connection acquired with http_client_pool_acquire() to the pool.
+ * If the connection was closed, for example by an error or the server, it is destroyed instead of kept idle.
+ */
+void http_client_pool_release( http_client_pool_t pool, http_client_t client );
+
+/**
+ * Close all idle connections that has been idle for longer than idle_timeout.
+ * This is also done on each acquire, call this to evict connections for hosts that are not used anymore.
+ */
+void http_client_pool_evict( http_client_pool_t pool );
+
+/**
+ * Get pool counters.
+ */
+void http_client_pool_get_stats( http_client_pool_t pool, http_client_pool_stats* stats );
+
+#endif // HTTP_CLIENT_POOL_H_INCLUDED
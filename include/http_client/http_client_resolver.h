@@ -0,0 +1,148 @@
+/*
+    Simple http-client written to be an drop-in code, focus is to be small
+    and easy to use but maybe not efficient.
+
+    version 1.0, June, 2014
+
+	Copyright (C) 2014- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+#ifndef HTTP_CLIENT_RESOLVER_H_INCLUDED
+#define HTTP_CLIENT_RESOLVER_H_INCLUDED
+
+#include <http_client/http_client.h>
+
+/**
+ * Handle to a resolver, a cache of host name lookups shared by clients, pools and multi-engines.
+ *
+ * Lookups are keyed by host/port and cached for a configurable time, failed lookups are cached as well for a
+ * shorter time. Concurrent lookups of the same host/port are coalesced into one, and lookups can be started
+ * without blocking with http_client_resolver_resolve_async(), run by a small set of worker threads.
+ *
+ * @note the system resolver does not report record ttls, the same ttl from the config is used for all entries.
+ *
+ * @example
+ *
+ * http_client_resolver_t resolver;
+ * http_client_resolver_create( &resolver, 0x0 );
+ * http_client_resolver_set_default( resolver );
+ *
+ * // ... connect clients as usual, all name lookups now goes through resolver ...
+ *
+ * http_client_resolver_set_default( 0x0 );
+ * http_client_resolver_destroy( resolver );
+ */
+typedef struct http_client_resolver* http_client_resolver_t;
+
+/**
+ * Configuration used when creating a resolver, 0 for any value use the default.
+ */
+struct http_client_resolver_config
+{
+	unsigned int ttl;          ///< ms to cache a successful lookup, defaults to 60000.
+	unsigned int negative_ttl; ///< ms to cache a failed lookup, defaults to 5000.
+	unsigned int max_entries;  ///< max number of host/port entries cached, least recently used are evicted first. Defaults to 256.
+	unsigned int num_threads;  ///< number of threads running asynchronous lookups, defaults to 2.
+};
+
+/**
+ * Counters reported by http_client_resolver_get_stats().
+ */
+struct http_client_resolver_stats
+{
+	unsigned long long hits;          ///< lookups answered from the cache, including cached failures.
+	unsigned long long misses;        ///< lookups that needed a query to the system resolver.
+	unsigned long long coalesced;     ///< lookups that joined a query already in flight for the same host/port.
+	unsigned long long failures;      ///< queries to the system resolver that failed.
+	unsigned long long evicted;       ///< entries evicted to stay within max_entries.
+	unsigned int       entries;       ///< entries currently in the cache.
+};
+
+/**
+ * Callback called when a lookup started with http_client_resolver_resolve_async() is done.
+ *
+ * @param result HTTP_CLIENT_OK if the host was resolved, HTTP_CLIENT_SOCKET_ERROR if it could not be and
+ *               HTTP_CLIENT_ABORTED if the resolver was destroyed before the lookup was done.
+ * @param userdata userdata passed to http_client_resolver_resolve_async().
+ */
+typedef void (*http_client_resolve_callback)( http_client_result result, void* userdata );
+
+/**
+ * Create a new resolver.
+ *
+ * @param resolver ptr to http_client_resolver_t to fill.
+ * @param config configuration, can be NULL for defaults.
+ *
+ * @return HTTP_CLIENT_OK on success.
+ */
+http_client_result http_client_resolver_create( http_client_resolver_t* resolver, const http_client_resolver_config* config );
+
+/**
+ * Destroy resolver, waiting for lookups currently running. Lookups not yet started are completed with
+ * HTTP_CLIENT_ABORTED. The resolver must not be the default resolver or be used by any multi-engine.
+ */
+void http_client_resolver_destroy( http_client_resolver_t resolver );
+
+/**
+ * Set resolver used by http_client_connect(), http_client_pool_acquire() and multi-engines without a resolver of
+ * their own, NULL to do a blocking lookup for each new connection. Not thread-safe, set before any client is
+ * connected.
+ */
+void http_client_resolver_set_default( http_client_resolver_t resolver );
+
+/**
+ * Start a lookup of host/port without blocking, useful to warm the cache ahead of connecting.
+ *
+ * callback is called directly if the result is already cached, otherwise from a resolver thread when the lookup is
+ * done. When called from a resolver thread the resolver is locked, the callback must be quick and must not call
+ * any resolver functions.
+ *
+ * @param resolver resolver to use.
+ * @param host host name to look up.
+ * @param port port to look up.
+ * @param callback called when lookup is done, can be NULL to just warm the cache.
+ * @param userdata passed to callback.
+ *
+ * @return HTTP_CLIENT_OK if the lookup was started or already done.
+ */
+http_client_result http_client_resolver_resolve_async( http_client_resolver_t resolver,
+													   const char* host,
+													   unsigned int port,
+													   http_client_resolve_callback callback,
+													   void* userdata );
+
+/**
+ * Remove all pending callbacks to callback with userdata, after this call callback will not be called with userdata
+ * by the resolver.
+ */
+void http_client_resolver_cancel( http_client_resolver_t resolver, http_client_resolve_callback callback, void* userdata );
+
+/**
+ * Drop all cached lookups, lookups in flight are kept.
+ */
+void http_client_resolver_flush( http_client_resolver_t resolver );
+
+/**
+ * Get resolver counters.
+ */
+void http_client_resolver_get_stats( http_client_resolver_t resolver, http_client_resolver_stats* stats );
+
+#endif // HTTP_CLIENT_RESOLVER_H_INCLUDED
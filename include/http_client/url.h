@@ -87,7 +87,7 @@ struct parse_url_ctx
 	size_t memleft;
 };
 
-const char* parse_url_strnchr( const char* str, size_t len, int ch )
+static const char* parse_url_strnchr( const char* str, size_t len, int ch )
 {
 	for( size_t i = 0; i < len; ++i )
 		if( str[i] == ch )
@@ -27,23 +27,14 @@
 
 #define URL_PARSER_IMPLEMENTATION_STATIC
 
-#include <http_client/http_client.h>
-#include <http_client/url.h>
+#include "http_client_internal.h"
 
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
 
 #if defined( _MSC_VER )
-#  undef UNICODE
-#  include <winsock2.h>
-#  include <ws2tcpip.h>
-#
-#  define snprintf _snprintf
-#  define strncasecmp _strnicmp
-
-	typedef SSIZE_T ssize_t;
-
+#  include <io.h>
 	// http://stackoverflow.com/questions/2188914/c-searching-for-a-string-in-a-file
 	static void *memmem(const void *haystack, size_t hlen, const void *needle, size_t nlen)
 	{
@@ -67,28 +58,109 @@
 		return NULL;
 	}
 #else
-#  include <sys/types.h>
-#  include <sys/socket.h>
-#  include <netinet/in.h>
-#  include <arpa/inet.h>
-#  include <unistd.h>
-#  include <netdb.h>
+#  include <time.h>
+#  include <fcntl.h>
+#endif
+
+#if defined( __linux__ )
+#  include <sys/sendfile.h>
 #endif
 
-struct http_client
+/**
+ * Max number of requests to have in flight on a connection when pipelining. Requests are sent in windows of this size
+ * so that neither side blocks on a full socket buffer while the other is not reading.
+ */
+#if !defined( HTTP_CLIENT_PIPELINE_DEPTH )
+#  define HTTP_CLIENT_PIPELINE_DEPTH 32
+#endif
+
+/**
+ * Body of a request, either in memory, size bytes read from a file starting at offset or, if producer is set, pulled
+ * from producer and sent with chunked transfer-encoding.
+ */
+struct http_request_body
 {
-	int sockfd;
-	parsed_url* url;
-	const char* useragent;
+	const void* data;  ///< in-memory body or NULL to send from fd or producer.
+	size_t size;
+	int    fd;
+	size_t offset;
+	http_client_body_producer producer;
+	void* userdata;
 };
 
+/**
+ * Receive-state of a connection. Data in buffer between read_pos and write_pos is received but not yet parsed, lines
+ * are parsed in place and the unparsed data is only moved down to base when there is no room left after it.
+ * Data below base is never moved, used to keep the header block of the current response in place.
+ */
 struct http_request_ctx
 {
-	char   buffer[2048];
-	size_t bytes_in_buffer;
+	char*  buffer;
+	size_t buffer_size;
+	size_t base;       ///< start of the part of buffer that may be reused, always <= read_pos.
+	size_t read_pos;   ///< start of received, unparsed data.
+	size_t write_pos;  ///< end of received data.
+	size_t scan_pos;   ///< position from where to continue looking for end-of-line, everything before it is known not to contain one.
+	size_t bytes_read; ///< total bytes received since ctx was reset.
+	http_client_t client;
 };
 
-static void http_client_close_socket( int sockfd )
+static void http_client_ctx_init( http_request_ctx* ctx, http_client_t client )
+{
+	ctx->buffer      = client->recv_buffer;
+	ctx->buffer_size = client->recv_buffer_size;
+	ctx->base        = 0;
+	ctx->read_pos    = 0;
+	ctx->write_pos   = 0;
+	ctx->scan_pos    = 0;
+	ctx->bytes_read  = 0;
+	ctx->client      = client;
+}
+
+/**
+ * Account for a recv() on ctx that returned bytes_read.
+ */
+static void http_client_ctx_received( http_request_ctx* ctx, ssize_t bytes_read )
+{
+	http_client_stats* stats = &ctx->client->stats;
+	++stats->recv_calls;
+	if( bytes_read <= 0 )
+		return;
+	if( stats->first_byte == 0 )
+		stats->first_byte = http_client_time_us();
+	stats->bytes_received += (size_t)bytes_read;
+	ctx->bytes_read += (size_t)bytes_read;
+}
+
+static size_t http_client_ctx_buffered( const http_request_ctx* ctx )
+{
+	return ctx->write_pos - ctx->read_pos;
+}
+
+static void http_client_ctx_consume( http_request_ctx* ctx, size_t bytes )
+{
+	ctx->read_pos += bytes;
+	if( ctx->scan_pos < ctx->read_pos )
+		ctx->scan_pos = ctx->read_pos;
+
+	// ... rewind for free when all data is consumed ...
+	if( ctx->read_pos == ctx->write_pos )
+		ctx->read_pos = ctx->write_pos = ctx->scan_pos = ctx->base;
+}
+
+/**
+ * Move data from offset from up to write_pos down to offset to.
+ */
+static void http_client_ctx_compact( http_request_ctx* ctx, size_t from, size_t to )
+{
+	size_t shift = from - to;
+	memmove( ctx->buffer + to, ctx->buffer + from, ctx->write_pos - from );
+	ctx->read_pos  -= shift;
+	ctx->scan_pos  -= shift;
+	ctx->write_pos -= shift;
+}
+
+void http_client_close_socket( int sockfd )
 {
 #if defined( _MSC_VER )
 	closesocket( sockfd );
@@ -97,7 +169,7 @@ static void http_client_close_socket( int sockfd )
 #endif
 }
 
-static void* http_client_alloc( void* ptr, size_t size, http_client_allocator* alloc )
+void* http_client_alloc( void* ptr, size_t size, http_client_allocator* alloc )
 {
 	if( alloc == 0x0 )
 		return realloc( ptr, size );
@@ -122,304 +194,1817 @@ static parsed_url* http_client_parse_url( const char* url, char* mem, size_t mem
 	return parsed;
 }
 
-size_t http_client_calc_mem_usage( const char* url )
+/**
+ * Reset stats of client at the start of a call.
+ */
+static void http_client_stats_begin( http_client_t client )
 {
-	return sizeof( http_client ) + parse_url_calc_mem_usage( url );
+	memset( &client->stats, 0x0, sizeof( client->stats ) );
+	client->stats.start = http_client_time_us();
 }
 
-http_client_result http_client_connect( http_client_t* c, const char* url, const char* useragent, void* usermem, size_t memsize )
+/**
+ * Start a call on client, resetting stats and setting up the deadline of the call.
+ */
+static void http_client_call_begin( http_client_t client )
 {
-	size_t neededsize = http_client_calc_mem_usage( url );
-	void* mem = usermem;
-	if( mem == 0x0 )
-	{
-		mem = malloc( neededsize );
-		memsize = neededsize;
-	}
-	if( memsize < neededsize )
-		return HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+	http_client_stats_begin( client );
+	client->deadline = client->timeouts.request ? http_client_time_ms() + client->timeouts.request : 0;
+}
 
-	http_client* client = (http_client*)mem;
-	client->sockfd = -1;
-	client->useragent = useragent ? useragent : "http-client";
-	client->url = http_client_parse_url( url, (char*)mem + sizeof( http_client ), neededsize - sizeof( http_client ) );
-	if( client->url == 0x0 )
-	{
-		if( usermem == 0x0 )
-			free( mem );
-		*c = 0x0;
-		return HTTP_CLIENT_INVALID_URL;
-	}
+/**
+ * Add the stats of a call made as part of a larger one to the stats of the larger one, phases of from overrides
+ * the ones in into.
+ */
+static void http_client_stats_merge( http_client_stats* into, const http_client_stats* from )
+{
+	if( from->dns_done )     into->dns_done     = from->dns_done;
+	if( from->connect_done ) into->connect_done = from->connect_done;
+	if( from->request_sent ) into->request_sent = from->request_sent;
+	if( from->first_byte )   into->first_byte   = from->first_byte;
+	if( from->headers_done ) into->headers_done = from->headers_done;
+	into->bytes_sent     += from->bytes_sent;
+	into->bytes_received += from->bytes_received;
+	into->send_calls     += from->send_calls;
+	into->recv_calls     += from->recv_calls;
+	into->retries        += from->retries;
+}
 
-	addrinfo hints;
-	memset( &hints, 0x0, sizeof(hints) );
-	hints.ai_family = AF_INET;
-	hints.ai_socktype = SOCK_STREAM;
+static const http_client_hooks http_client_no_hooks = { 0x0, 0x0, 0x0, 0x0, 0x0, 0x0 };
+static http_client_timeouts http_client_default_timeouts = { 0, 0, 0, 0, 0, 0 };
 
-	char port[8];
-	snprintf( port, 8, "%u", client->url->port );
-	struct addrinfo* result;
-	int error = getaddrinfo( client->url->host, port, &hints, &result );
-	if( error != 0 )
-	{
-		if( usermem == 0x0 )
-			free( mem );
-		*c = 0x0;
-		return HTTP_CLIENT_SOCKET_ERROR;
-	}
+void http_client_set_hooks( http_client_t client, const http_client_hooks* hooks, void* userdata )
+{
+	client->hooks = hooks ? hooks : &http_client_no_hooks;
+	client->hooks_userdata = userdata;
+}
 
-	for( addrinfo* res_iter = result; res_iter != NULL; res_iter = res_iter->ai_next )
-	{
-		client->sockfd = socket( res_iter->ai_family, res_iter->ai_socktype, res_iter->ai_protocol );
-		if( client->sockfd < 0 )
-			continue;
+void http_client_get_stats( http_client_t client, http_client_stats* stats )
+{
+	*stats = client->stats;
+}
 
-		if( connect( client->sockfd, res_iter->ai_addr, res_iter->ai_addrlen ) < 0 )
-		{
-			http_client_close_socket( client->sockfd );
-			client->sockfd = -1;
-			continue;
-		}
-	}
-	freeaddrinfo( result );
+void http_client_set_default_timeouts( const http_client_timeouts* timeouts )
+{
+	if( timeouts )
+		http_client_default_timeouts = *timeouts;
+	else
+		memset( &http_client_default_timeouts, 0x0, sizeof( http_client_default_timeouts ) );
+}
 
-	if( client->sockfd < 0 )
+const http_client_timeouts* http_client_get_default_timeouts()
+{
+	return &http_client_default_timeouts;
+}
+
+void http_client_set_timeouts( http_client_t client, const http_client_timeouts* timeouts )
+{
+	client->timeouts = timeouts ? *timeouts : http_client_default_timeouts;
+}
+
+unsigned int http_client_set_decompression( http_client_t client, unsigned int encodings )
+{
+	client->decode_encodings = encodings & http_client_decoder_supported();
+	http_client_decoder_accept_encoding( client->accept_encoding, sizeof( client->accept_encoding ), client->decode_encodings );
+	return client->decode_encodings;
+}
+
+static void http_client_drop_connection( http_client_t client )
+{
+	if( client->sockfd >= 0 )
 	{
-		if( usermem == 0x0 )
-			free( mem );
-		*c = 0x0;
-		return HTTP_CLIENT_SOCKET_ERROR;
+		http_client_close_socket( client->sockfd );
+		HTTP_CLIENT_HOOK( client, connection, ( HTTP_CLIENT_CONNECTION_CLOSED, client->hooks_userdata ) );
 	}
+	client->sockfd = -1;
+	client->socket_uses = 0;
+}
 
-	*c = client;
-
-    return HTTP_CLIENT_OK;
+static bool http_client_set_nonblocking( int sockfd )
+{
+#if defined( _MSC_VER )
+	u_long mode = 1;
+	return ioctlsocket( (SOCKET)sockfd, FIONBIO, &mode ) == 0;
+#else
+	int flags = fcntl( sockfd, F_GETFL, 0 );
+	return flags >= 0 && fcntl( sockfd, F_SETFL, flags | O_NONBLOCK ) == 0;
+#endif
 }
 
-void http_client_disconnect( http_client_t client )
+/**
+ * Check if the last failed socket-call failed because it would have blocked.
+ */
+static bool http_client_would_block()
 {
-    // ... disconnect here ... ;)
-	http_client_close_socket( client->sockfd );
+#if defined( _MSC_VER )
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+	return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
 }
 
-static http_client_result http_client_readline( int sock_fd, http_request_ctx* ctx, size_t* consumed )
+/**
+ * Wait for the socket of client to become readable or writable, for no longer than the read or write timeout and
+ * deadline of client allows.
+ */
+static http_client_result http_client_wait_socket( http_client_t client, bool write )
 {
+	http_client_result timeout_res = write ? HTTP_CLIENT_WRITE_TIMEOUT : HTTP_CLIENT_READ_TIMEOUT;
+	unsigned int timeout = write ? client->timeouts.write : client->timeouts.read;
+	unsigned long long start = http_client_time_ms();
+
+	pollfd pfd;
+	pfd.fd      = client->sockfd;
+	pfd.events  = write ? POLLOUT : POLLIN;
+	pfd.revents = 0;
 	while( true )
 	{
-		if( char* eol = (char*)memmem( ctx->buffer, ctx->bytes_in_buffer, "\r\n", 2 ) )
+		// ... recalculated on each try, a poll interrupted by a signal must not restart the full timeout ...
+		unsigned long long now = http_client_time_ms();
+		int wait = -1;
+		if( timeout != 0 )
 		{
-			*eol = '\0';
-			*consumed = (size_t)(eol + 2 - ctx->buffer);
-			return HTTP_CLIENT_OK;
+			if( now - start >= timeout )
+				return timeout_res;
+			unsigned long long left = timeout - ( now - start );
+			wait = left > 0x7fffffff ? 0x7fffffff : (int)left;
+		}
+		if( client->deadline != 0 )
+		{
+			if( now >= client->deadline )
+				return timeout_res;
+			if( wait < 0 || client->deadline - now < (unsigned long long)wait )
+				wait = client->deadline - now > 0x7fffffff ? 0x7fffffff : (int)( client->deadline - now );
 		}
 
-		ssize_t bytes_read = recv( sock_fd, ctx->buffer, sizeof( ctx->buffer ), 0 );
-		if( bytes_read == 0 )
-			return HTTP_CLIENT_CONNECTION_LOST;
-		if( bytes_read < 0 && errno != EAGAIN )
-			return HTTP_CLIENT_INTERNAL_ERROR;
-		else
-			ctx->bytes_in_buffer += bytes_read;
-	};
-
-	return HTTP_CLIENT_INTERNAL_ERROR;
+		int res = poll( &pfd, 1, wait );
+		if( res > 0 )
+			return HTTP_CLIENT_OK; // ... errors and hangups are reported by the following send/recv ...
+		if( res == 0 )
+			return timeout_res;
+		if( errno != EINTR )
+			return HTTP_CLIENT_SOCKET_ERROR;
+	}
 }
 
-static void http_client_finalize_line( http_request_ctx* ctx, size_t consumed )
+static bool http_client_connect_in_progress()
 {
-	ctx->bytes_in_buffer -= consumed;
-	memmove( ctx->buffer, &ctx->buffer[consumed], ctx->bytes_in_buffer );
+#if defined( _MSC_VER )
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+	return errno == EINPROGRESS || errno == EINTR;
+#endif
 }
 
-static http_client_result http_client_read_status_line( int sockfd, http_request_ctx* ctx, unsigned int* error_code )
+struct http_connect_attempt
 {
-	unsigned int protocol_major = 0;
-	unsigned int protocol_minor = 0;
-
-	size_t consumed = 0;
-	http_client_result res = http_client_readline( sockfd, ctx, &consumed );
-	if( res != HTTP_CLIENT_OK )
-		return res;
-
-	if( sscanf( ctx->buffer, "HTTP/%u.%u %u", &protocol_major, &protocol_minor, error_code ) != 3 )
-		return HTTP_CLIENT_SOCKET_ERROR;
-
-	http_client_finalize_line( ctx, consumed );
-	return HTTP_CLIENT_OK;
-}
+	int fd;
+	unsigned int addr;           ///< index in address list.
+	unsigned long long started;  ///< time in ms when the attempt was started.
+};
 
-static http_client_result http_client_make_request( http_client_t client, http_request_ctx* ctx, const char* verb, const char* resource, size_t* content_length, const void* payload, size_t payload_size )
+/**
+ * Connect to the first address of addrs that accepts a connection, racing them as described at http_client_timeouts.
+ * Connecting is abandoned at deadline if it is non-zero and before the connect timeout.
+ * On success the connected socket, in non-blocking mode, is returned in *sockfd and the index of its address in *index.
+ */
+static http_client_result http_client_connect_race( const http_client_addr_list* addrs, const http_client_timeouts* timeouts, unsigned long long deadline, int* sockfd, unsigned int* index )
 {
-	char request[2048];
-	if( payload == 0x0 )
-	{
-		size_t request_len = snprintf( request, sizeof(request), "%s %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: %s\r\n\r\n", verb, resource, client->url->host, client->useragent );
-		if( send( client->sockfd, request, request_len, 0 ) < 0 )
-			return HTTP_CLIENT_SOCKET_ERROR;
-	}
-	else
+	http_connect_attempt attempts[HTTP_CLIENT_MAX_ADDRS];
+	pollfd pfds[HTTP_CLIENT_MAX_ADDRS];
+	unsigned int num_attempts = 0;
+	unsigned int next = 0;
+	bool timed_out = false;
+
+	unsigned int delay = timeouts->connect_attempt_delay ? timeouts->connect_attempt_delay : 250;
+	unsigned long long now = http_client_time_ms();
+	if( timeouts->connect != 0 && ( deadline == 0 || now + timeouts->connect < deadline ) )
+		deadline = now + timeouts->connect;
+	unsigned long long next_start = now;
+	int winner = -1;
+
+	while( winner < 0 )
 	{
-		size_t request_len = snprintf( request, sizeof(request), "%s %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: %s\r\nContent-Length: %lu\r\n\r\n", verb, resource, client->url->host, client->useragent, payload_size );
-		if( send( client->sockfd, request, request_len, 0 ) < 0 )
-			return HTTP_CLIENT_SOCKET_ERROR;
-		if( send( client->sockfd, (const char*)payload, payload_size, 0 ) < 0 )
-			return HTTP_CLIENT_SOCKET_ERROR;
-	}
-
-	http_client_result res;
-	unsigned int error_code = 0;
-	res = http_client_read_status_line( client->sockfd, ctx, &error_code );
-	if( res != HTTP_CLIENT_OK )
-		return res;
+		// ... start the next attempt when it is due or if nothing else is in flight, failed addresses are skipped directly ...
+		while( next < addrs->count && ( now >= next_start || num_attempts == 0 ) )
+		{
+			unsigned int addr = next++;
+			int fd = (int)socket( addrs->addrs[addr].ss_family, SOCK_STREAM, 0 );
+			if( fd < 0 )
+				continue;
+
+			bool connected = false;
+			if( http_client_set_nonblocking( fd ) )
+			{
+				connected = connect( fd, (const sockaddr*)&addrs->addrs[addr], addrs->lens[addr] ) == 0;
+				if( connected || http_client_connect_in_progress() )
+				{
+					attempts[num_attempts].fd      = fd;
+					attempts[num_attempts].addr    = addr;
+					attempts[num_attempts].started = now;
+					pfds[num_attempts].fd      = fd;
+					pfds[num_attempts].events  = POLLOUT;
+					pfds[num_attempts].revents = 0;
+					if( connected )
+						winner = (int)num_attempts;
+					++num_attempts;
+					next_start = now + delay;
+					break;
+				}
+			}
+			http_client_close_socket( fd );
+		}
 
-	if( error_code >= 300 )
-		return (http_client_result)error_code;
+		if( winner >= 0 )
+			break;
 
-	for( bool done = false; !done; )
-    {
-    	size_t consumed = 0;
-    	http_client_result res = http_client_readline( client->sockfd, ctx, &consumed );
-		if( res != HTTP_CLIENT_OK )
-			return res;
+		if( num_attempts == 0 )
+			return timed_out ? HTTP_CLIENT_CONNECT_TIMEOUT : HTTP_CLIENT_SOCKET_ERROR;
 
-		printf("%s\n", ctx->buffer);
-		if( ctx->buffer[0] == '\0' )
+		if( deadline != 0 && now >= deadline )
 		{
-			done = true;
+			timed_out = true;
+			break;
 		}
-		else if( strncasecmp( ctx->buffer, "content-length:", 15 ) == 0 )
-		{
-			if( content_length )
-				*content_length = atoi( &ctx->buffer[16] );
-		}
-		else if( strncasecmp( ctx->buffer, "transfer-encoding:", 18 ) == 0 )
+
+		// ... sleep until an attempt completes, the next attempt is due or something times out ...
+		unsigned long long wake = next < addrs->count ? next_start : (unsigned long long)-1;
+		if( deadline != 0 && deadline < wake )
+			wake = deadline;
+		for( unsigned int i = 0; i < num_attempts && timeouts->connect_attempt != 0; ++i )
+			if( attempts[i].started + timeouts->connect_attempt < wake )
+				wake = attempts[i].started + timeouts->connect_attempt;
+
+		int wait = -1;
+		if( wake != (unsigned long long)-1 )
+			wait = wake <= now ? 0 : ( wake - now > 0x7fffffff ? 0x7fffffff : (int)( wake - now ) );
+
+		int ready = poll( pfds, (unsigned int)num_attempts, wait );
+		if( ready < 0 && errno != EINTR )
+			break;
+		now = http_client_time_ms();
+
+		// ... iterate backwards so that removing an attempt by moving the last one to its place is safe ...
+		for( unsigned int i = num_attempts; i-- > 0 && winner < 0; )
 		{
-			if( strncasecmp( ctx->buffer + 19, "chunked", 7 ) == 0 )
-				*content_length = 0;
+			bool failed = false;
+			if( ready > 0 && pfds[i].revents != 0 )
+			{
+				int err = 0;
+				socklen_t len = sizeof( err );
+				if( getsockopt( attempts[i].fd, SOL_SOCKET, SO_ERROR, (char*)&err, &len ) == 0 && err == 0 && ( pfds[i].revents & POLLOUT ) )
+					winner = (int)i;
+				else
+					failed = true;
+			}
+			else if( timeouts->connect_attempt != 0 && now - attempts[i].started >= timeouts->connect_attempt )
+			{
+				failed = true;
+				timed_out = true;
+			}
+
+			if( failed )
+			{
+				http_client_close_socket( attempts[i].fd );
+				--num_attempts;
+				attempts[i] = attempts[num_attempts];
+				pfds[i]     = pfds[num_attempts];
+				next_start  = now; // ... no reason to wait with the next attempt when one has failed ...
+			}
 		}
+	}
 
-		http_client_finalize_line( ctx, consumed );
-    }
+	// ... keep the winner, if any, and close the losers ...
+	for( unsigned int i = 0; i < num_attempts; ++i )
+		if( (int)i != winner )
+			http_client_close_socket( attempts[i].fd );
 
+	if( winner < 0 )
+		return timed_out ? HTTP_CLIENT_CONNECT_TIMEOUT : HTTP_CLIENT_SOCKET_ERROR;
+
+	*sockfd = attempts[winner].fd;
+	*index  = attempts[winner].addr;
 	return HTTP_CLIENT_OK;
 }
 
-static void http_client_recv_bytes( int sockfd, char* outbuf, size_t bytes )
+static http_client_result http_client_open_socket( http_client_t client )
 {
-	size_t read = 0;
-	while( read < bytes )
+	http_client_addr_list addrs;
+	http_client_result res = HTTP_CLIENT_SOCKET_ERROR;
+	int sockfd = -1;
+	unsigned int index = 0;
+
+	// ... reconnect to the address we used last time to skip the name lookup ...
+	if( client->addrlen != 0 )
 	{
-		ssize_t res = recv( sockfd, outbuf + read, bytes - read, 0 );
-		// TODO: handle error!
-		read += res;
+		addrs.count    = 1;
+		addrs.addrs[0] = client->addr;
+		addrs.lens[0]  = client->addrlen;
+		res = http_client_connect_race( &addrs, &client->timeouts, client->deadline, &sockfd, &index );
 	}
-}
 
-static http_client_result http_client_read_chunk_size( int sockfd, http_request_ctx* ctx, size_t* chunk_size )
-{
-	while( true )
+	if( res != HTTP_CLIENT_OK )
 	{
-		size_t consumed = 0;
-		http_client_result res = http_client_readline( sockfd, ctx, &consumed );
+		res = http_client_resolve( http_client_resolver_get_default(), client->url->host, client->url->port, &addrs );
 		if( res != HTTP_CLIENT_OK )
 			return res;
+		client->stats.dns_done = http_client_time_us();
 
-		// ... check and ignore empty lines ...
-		if( ctx->buffer[0] != 0 )
+		res = http_client_connect_race( &addrs, &client->timeouts, client->deadline, &sockfd, &index );
+		if( res != HTTP_CLIENT_OK )
+			return res;
+	}
+
+	client->stats.connect_done = http_client_time_us();
+	http_client_set_nodelay( sockfd );
+	client->addr        = addrs.addrs[index];
+	client->addrlen     = addrs.lens[index];
+	client->sockfd      = sockfd;
+	client->socket_uses = 0;
+	HTTP_CLIENT_HOOK( client, connection, ( HTTP_CLIENT_CONNECTION_OPENED, client->hooks_userdata ) );
+	return HTTP_CLIENT_OK;
+}
+
+void http_client_set_nodelay( int sockfd )
+{
+	int one = 1;
+	setsockopt( sockfd, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof( one ) );
+}
+
+ssize_t http_client_sendv( int sockfd, const http_client_iovec* iov, int iov_count )
+{
+#if defined( _MSC_VER )
+	DWORD sent = 0;
+	if( WSASend( (SOCKET)sockfd, (LPWSABUF)iov, (DWORD)iov_count, &sent, 0, 0x0, 0x0 ) != 0 )
+		return -1;
+	return (ssize_t)sent;
+#else
+	msghdr msg;
+	memset( &msg, 0x0, sizeof( msg ) );
+	msg.msg_iov    = (iovec*)iov;
+	msg.msg_iovlen = (size_t)iov_count;
+	return sendmsg( sockfd, &msg, MSG_NOSIGNAL );
+#endif
+}
+
+http_client_result http_client_sendv_all( http_client_t client, http_client_iovec* iov, int iov_count )
+{
+	while( iov_count > 0 )
+	{
+		ssize_t res = http_client_sendv( client->sockfd, iov, iov_count );
+		++client->stats.send_calls;
+		if( res < 0 )
 		{
-			*chunk_size = strtol( ctx->buffer, 0x0, 16 );
-			http_client_finalize_line( ctx, consumed );
-			return HTTP_CLIENT_OK;
+			if( errno == EINTR )
+				continue;
+			if( !http_client_would_block() )
+				return HTTP_CLIENT_SOCKET_ERROR;
+
+			http_client_result wait_res = http_client_wait_socket( client, true );
+			if( wait_res != HTTP_CLIENT_OK )
+				return wait_res;
+			continue;
 		}
+		client->stats.bytes_sent += (size_t)res;
 
-		http_client_finalize_line( ctx, consumed );
+		// ... skip what was sent, partial writes can end in the middle of any buffer ...
+		size_t sent = (size_t)res;
+		while( iov_count > 0 && sent >= http_client_iov_len( iov ) )
+		{
+			sent -= http_client_iov_len( iov );
+			++iov;
+			--iov_count;
+		}
+		if( iov_count > 0 )
+			http_client_iov_set( iov, http_client_iov_base( iov ) + sent, http_client_iov_len( iov ) - sent );
 	}
-
 	return HTTP_CLIENT_OK;
 }
 
-static size_t http_client_ctx_get_bytes( http_request_ctx* ctx, void* outbuffer )
+unsigned long long http_client_time_us()
 {
-	size_t bib = ctx->bytes_in_buffer;
-	memcpy( outbuffer, ctx->buffer, bib );
-	ctx->bytes_in_buffer = 0;
-	return bib;
+#if defined( _MSC_VER )
+	LARGE_INTEGER freq, now;
+	QueryPerformanceFrequency( &freq );
+	QueryPerformanceCounter( &now );
+	return (unsigned long long)( now.QuadPart / freq.QuadPart ) * 1000000ull + (unsigned long long)( now.QuadPart % freq.QuadPart ) * 1000000ull / (unsigned long long)freq.QuadPart;
+#else
+	timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (unsigned long long)ts.tv_sec * 1000000ull + (unsigned long long)ts.tv_nsec / 1000ull;
+#endif
 }
 
-http_client_result http_client_get( http_client_t client, const char* resource, void** msgbody, size_t* msgbody_size, http_client_allocator* alloc )
+unsigned long long http_client_time_ms()
 {
-    *msgbody = 0x0;
-    *msgbody_size = 0;
+#if defined( _MSC_VER )
+	return (unsigned long long)GetTickCount64();
+#else
+	timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (unsigned long long)ts.tv_sec * 1000ull + (unsigned long long)ts.tv_nsec / 1000000ull;
+#endif
+}
 
-    http_request_ctx ctx;
-    ctx.bytes_in_buffer = 0;
+bool http_client_socket_alive( int sockfd )
+{
+	pollfd pfd;
+	pfd.fd      = sockfd;
+	pfd.events  = POLLIN;
+	pfd.revents = 0;
+	if( poll( &pfd, 1, 0 ) == 0 )
+		return true; // ... nothing to read, idle as expected ...
+
+	// ... readable on an idle connection means either EOF, error or garbage we can't make sense of ...
+	char c;
+	ssize_t res = recv( sockfd, &c, 1, MSG_PEEK | MSG_DONTWAIT );
+	return res < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK );
+}
 
-    http_client_result res = http_client_make_request( client, &ctx, "GET", resource, msgbody_size, 0, 0 );
-    if( res != HTTP_CLIENT_OK )
-    	return res;
+size_t http_client_calc_mem_usage( const char* url )
+{
+	return http_client_calc_mem_usage_ex( url, HTTP_CLIENT_DEFAULT_RECV_BUFFER_SIZE );
+}
 
-    if( *msgbody_size == 0 )
-    {
-		while( true )
-		{
-			size_t chunk_size;
-			http_client_result res = http_client_read_chunk_size( client->sockfd, &ctx, &chunk_size );
-			if( res != HTTP_CLIENT_OK )
-				return res;
+size_t http_client_calc_mem_usage_ex( const char* url, size_t recv_buffer_size )
+{
+	return sizeof( http_client ) + recv_buffer_size + parse_url_calc_mem_usage( url );
+}
 
-			if( chunk_size == 0 )
-				break;
+/**
+ * Setup a client allocated with its receive buffer directly after it, without an url or connection.
+ */
+static void http_client_init( http_client* client, const char* useragent, size_t recv_buffer_size )
+{
+	client->sockfd = -1;
+	client->url = 0x0;
+	client->addrlen = 0;
+	client->socket_uses = 0;
+	client->useragent = useragent;
+	client->recv_buffer = (char*)client + sizeof( http_client );
+	client->recv_buffer_size = recv_buffer_size;
+	client->num_headers = 0;
+	memset( client->known_headers, 0x0, sizeof( client->known_headers ) );
+	http_client_stats_begin( client );
+	http_client_set_hooks( client, 0x0, 0x0 );
+	http_client_set_timeouts( client, 0x0 );
+	client->deadline = 0;
+	client->decode_encodings = 0;
+	client->decoder = 0x0;
+	client->accept_encoding[0] = '\0';
+	client->cache = 0x0;
+}
+
+http_client_result http_client_connect( http_client_t* c, const char* url, const char* useragent, void* usermem, size_t memsize )
+{
+	return http_client_connect_ex( c, url, useragent, HTTP_CLIENT_DEFAULT_RECV_BUFFER_SIZE, usermem, memsize );
+}
 
-			*msgbody = http_client_alloc( *msgbody, *msgbody_size + chunk_size, alloc );
-			if( *msgbody == 0x0 )
-				return HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+http_client_result http_client_connect_ex( http_client_t* c, const char* url, const char* useragent, size_t recv_buffer_size, void* usermem, size_t memsize )
+{
+	// ... need room for at least a status-line ...
+	if( recv_buffer_size < 256 )
+		return HTTP_CLIENT_BUFFER_TOO_SMALL;
 
-			char* chunk_tgt = (char*)*msgbody + *msgbody_size;
-			size_t bytes_copied = http_client_ctx_get_bytes( &ctx, chunk_tgt );
-			http_client_recv_bytes( client->sockfd, &chunk_tgt[bytes_copied], chunk_size - bytes_copied );
-			*msgbody_size += chunk_size;
-		}
-    }
-    else
-    {
-		*msgbody = http_client_alloc( 0x0, *msgbody_size, alloc );
-		if( *msgbody == 0x0 )
-			return HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+	size_t neededsize = http_client_calc_mem_usage_ex( url, recv_buffer_size );
+	void* mem = usermem;
+	if( mem == 0x0 )
+	{
+		mem = malloc( neededsize );
+		memsize = neededsize;
+	}
+	if( memsize < neededsize )
+		return HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+
+	http_client* client = (http_client*)mem;
+	http_client_init( client, useragent ? useragent : "http-client", recv_buffer_size );
+	client->url = http_client_parse_url( url, client->recv_buffer + recv_buffer_size, neededsize - sizeof( http_client ) - recv_buffer_size );
+	if( client->url == 0x0 )
+	{
+		if( usermem == 0x0 )
+			free( mem );
+		*c = 0x0;
+		return HTTP_CLIENT_INVALID_URL;
+	}
+
+	http_client_result res = http_client_open_socket( client );
+	if( res != HTTP_CLIENT_OK )
+	{
+		if( usermem == 0x0 )
+			free( mem );
+		*c = 0x0;
+		return res;
+	}
 
-		size_t bytes_copied = http_client_ctx_get_bytes( &ctx, *msgbody );
-		http_client_recv_bytes( client->sockfd, (char*)*msgbody + bytes_copied, *msgbody_size - bytes_copied );
-    }
+	*c = client;
 
     return HTTP_CLIENT_OK;
 }
 
-http_client_result http_client_head( http_client_t client, const char* resource, size_t* msgbody_size )
+http_client_result http_client_clone( http_client_t client, http_client_t* clone )
 {
-    *msgbody_size = 0;
-    http_request_ctx ctx;
-    ctx.bytes_in_buffer = 0;
-    return http_client_make_request( client, &ctx, "HEAD", resource, msgbody_size, 0, 0 );
+	http_client* c = (http_client*)malloc( sizeof( http_client ) + client->recv_buffer_size );
+	if( c == 0x0 )
+		return HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+
+	http_client_init( c, client->useragent, client->recv_buffer_size );
+	c->url      = client->url;
+	c->addr     = client->addr;
+	c->addrlen  = client->addrlen;
+	c->timeouts = client->timeouts;
+	c->decode_encodings = client->decode_encodings;
+	memcpy( c->accept_encoding, client->accept_encoding, sizeof( c->accept_encoding ) );
+
+	http_client_result res = http_client_open_socket( c );
+	if( res != HTTP_CLIENT_OK )
+	{
+		free( c );
+		return res;
+	}
+	*clone = c;
+	return HTTP_CLIENT_OK;
 }
 
-http_client_result http_client_post( http_client_t client, const char* resource, const void* msgbody, size_t msgbody_size )
+void http_client_disconnect( http_client_t client )
 {
-    http_request_ctx ctx;
-    ctx.bytes_in_buffer = 0;
-    return http_client_make_request( client, &ctx, "POST", resource, 0x0, msgbody, msgbody_size );
+	http_client_drop_connection( client );
+	http_client_decoder_destroy( client->decoder );
+	client->decoder = 0x0;
 }
 
-http_client_result http_client_put( http_client_t client, const char* resource, const void* msgbody, size_t msgbody_size )
+/**
+ * recv() on sock_fd for ctx, waiting for data for no longer than the read timeout and deadline of the client allows.
+ * *received is set to the number of bytes received, 0 if the server closed the connection.
+ */
+static http_client_result http_client_ctx_recv( int sock_fd, http_request_ctx* ctx, void* dst, size_t size, size_t* received )
 {
-    http_request_ctx ctx;
-    ctx.bytes_in_buffer = 0;
-    return http_client_make_request( client, &ctx, "PUT", resource, 0x0, msgbody, msgbody_size );
+	while( true )
+	{
+		ssize_t bytes_read = recv( sock_fd, (char*)dst, size, 0 );
+		http_client_ctx_received( ctx, bytes_read );
+		if( bytes_read >= 0 )
+		{
+			*received = (size_t)bytes_read;
+			return HTTP_CLIENT_OK;
+		}
+
+		if( errno == EINTR )
+			continue;
+		if( !http_client_would_block() )
+			return HTTP_CLIENT_SOCKET_ERROR;
+
+		http_client_result res = http_client_wait_socket( ctx->client, false );
+		if( res != HTTP_CLIENT_OK )
+			return res;
+	}
 }
 
-http_client_result http_client_delete( http_client_t client, const char* resource )
+/**
+ * Receive more data to ctx, compacting the unparsed data to the start of the buffer if there is no room after it.
+ * Fails with HTTP_CLIENT_BUFFER_TOO_SMALL if the buffer is full of unparsed data.
+ */
+static http_client_result http_client_ctx_fill( int sock_fd, http_request_ctx* ctx )
 {
-    http_request_ctx ctx;
-    ctx.bytes_in_buffer = 0;
-    return http_client_make_request( client, &ctx, "DELETE", resource, 0x0, 0x0, 0 );
+	if( ctx->write_pos == ctx->buffer_size )
+	{
+		if( ctx->read_pos == ctx->base )
+			return HTTP_CLIENT_BUFFER_TOO_SMALL;
+
+		// ... compact, only ever needed once per buffer-full of data ...
+		http_client_ctx_compact( ctx, ctx->read_pos, ctx->base );
+	}
+
+	size_t bytes_read = 0;
+	http_client_result res = http_client_ctx_recv( sock_fd, ctx, ctx->buffer + ctx->write_pos, ctx->buffer_size - ctx->write_pos, &bytes_read );
+	if( res != HTTP_CLIENT_OK )
+		return res;
+	if( bytes_read == 0 )
+		return HTTP_CLIENT_CONNECTION_LOST;
+	ctx->write_pos += bytes_read;
+	return HTTP_CLIENT_OK;
+}
+
+/**
+ * Read the next line from ctx, receiving more data if needed. *line is set to the line, zero-terminated in place
+ * without the CRLF, and is valid until the next read from ctx.
+ */
+static http_client_result http_client_readline( int sock_fd, http_request_ctx* ctx, char** line )
+{
+	while( true )
+	{
+		if( char* eol = (char*)memmem( ctx->buffer + ctx->scan_pos, ctx->write_pos - ctx->scan_pos, "\r\n", 2 ) )
+		{
+			*eol = '\0';
+			*line = ctx->buffer + ctx->read_pos;
+			http_client_ctx_consume( ctx, (size_t)(eol + 2 - *line) );
+			return HTTP_CLIENT_OK;
+		}
+
+		// ... a '\r' at the end might be the start of the next CRLF ...
+		ctx->scan_pos = ctx->write_pos > ctx->read_pos ? ctx->write_pos - 1 : ctx->read_pos;
+
+		http_client_result res = http_client_ctx_fill( sock_fd, ctx );
+		if( res != HTTP_CLIENT_OK )
+			return res;
+	};
+
+	return HTTP_CLIENT_INTERNAL_ERROR;
+}
+
+bool http_client_parse_status_line( const char* line, unsigned int* protocol_major, unsigned int* protocol_minor, unsigned int* status )
+{
+	return sscanf( line, "HTTP/%u.%u %u", protocol_major, protocol_minor, status ) == 3;
+}
+
+size_t http_client_parse_chunk_size( const char* line )
+{
+	return (size_t)strtoull( line, 0x0, 16 );
+}
+
+static http_client_result http_client_read_status_line( int sockfd, http_request_ctx* ctx, unsigned int* protocol_major, unsigned int* protocol_minor, unsigned int* error_code )
+{
+	char* line;
+	http_client_result res = http_client_readline( sockfd, ctx, &line );
+	if( res != HTTP_CLIENT_OK )
+		return res;
+
+	if( !http_client_parse_status_line( line, protocol_major, protocol_minor, error_code ) )
+		return HTTP_CLIENT_SOCKET_ERROR;
+	return HTTP_CLIENT_OK;
+}
+
+/**
+ * Check if a comma-separated header value contains token, case-insensitive.
+ */
+bool http_client_header_has_token( const char* value, const char* token )
+{
+	size_t toklen = strlen( token );
+	while( *value )
+	{
+		while( *value == ' ' || *value == '\t' || *value == ',' )
+			++value;
+		const char* end = value;
+		while( *end && *end != ',' )
+			++end;
+		const char* tokend = end;
+		while( tokend > value && ( tokend[-1] == ' ' || tokend[-1] == '\t' ) )
+			--tokend;
+		if( (size_t)( tokend - value ) == toklen && strncasecmp( value, token, toklen ) == 0 )
+			return true;
+		value = end;
+	}
+	return false;
+}
+
+void http_client_parse_header( http_response* response, http_client_header_id id, const char* value )
+{
+	while( *value == ' ' || *value == '\t' )
+		++value;
+
+	switch( id )
+	{
+		case HTTP_CLIENT_HEADER_CONTENT_LENGTH:
+			response->content_length = (size_t)strtoull( value, 0x0, 10 );
+			response->has_content_length = true;
+			break;
+		case HTTP_CLIENT_HEADER_TRANSFER_ENCODING:
+			if( http_client_header_has_token( value, "chunked" ) )
+				response->chunked = true;
+			break;
+		case HTTP_CLIENT_HEADER_CONTENT_ENCODING:
+			response->content_encoding = http_client_decoder_parse_encoding( value );
+			break;
+		case HTTP_CLIENT_HEADER_CONNECTION:
+			if( http_client_header_has_token( value, "close" ) )
+				response->keep_alive = false;
+			else if( http_client_header_has_token( value, "keep-alive" ) )
+				response->keep_alive = true;
+			break;
+		default:
+			break;
+	}
+}
+
+void http_client_parse_header_line( const char* line, http_response* response )
+{
+	if( const char* colon = strchr( line, ':' ) )
+		http_client_parse_header( response, http_client_classify_header( line, (size_t)( colon - line ) ), colon + 1 );
+}
+
+void http_client_response_init( http_response* response, unsigned int protocol_major, unsigned int protocol_minor, unsigned int status )
+{
+	memset( response, 0x0, sizeof( http_response ) );
+	response->status     = status;
+	response->keep_alive = protocol_major > 1 || ( protocol_major == 1 && protocol_minor >= 1 );
+}
+
+void http_client_response_headers_done( http_response* response, const char* verb )
+{
+	// ... a body that is not chunked and has no length is delimited by the server closing the connection, responses
+	//     that never has a body, i.e. HEAD, 204 and 304, ends with the headers and need no length ...
+	if( !response->chunked && !response->has_content_length && http_client_response_has_body( verb, response->status ) )
+		response->keep_alive = false;
+}
+
+bool http_client_response_has_body( const char* verb, unsigned int status )
+{
+	if( strcmp( verb, "HEAD" ) == 0 )
+		return false;
+	return !( status == 204 || status == 304 || ( status >= 100 && status < 200 ) );
+}
+
+int http_client_format_request( char* buffer, size_t buffer_size, const char* verb, const char* resource, const char* host, const char* useragent, size_t content_length, const char* headers )
+{
+	if( headers == 0x0 )
+		headers = "";
+	if( content_length == HTTP_CLIENT_NO_BODY )
+		return snprintf( buffer, buffer_size, "%s %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: %s\r\n%s\r\n", verb, resource, host, useragent, headers );
+	if( content_length == HTTP_CLIENT_CHUNKED_BODY )
+		return snprintf( buffer, buffer_size, "%s %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: %s\r\nTransfer-Encoding: chunked\r\n%s\r\n", verb, resource, host, useragent, headers );
+	return snprintf( buffer, buffer_size, "%s %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: %s\r\nContent-Length: %lu\r\n%s\r\n", verb, resource, host, useragent, (unsigned long)content_length, headers );
+}
+
+/**
+ * Send size bytes from file fd starting at offset, with sendfile() where available and read()/send() otherwise.
+ */
+static http_client_result http_client_send_file( http_client_t client, int fd, size_t offset, size_t size )
+{
+#if defined( __linux__ )
+	off_t off = (off_t)offset;
+	while( size > 0 )
+	{
+		ssize_t res = sendfile( client->sockfd, fd, &off, size );
+		++client->stats.send_calls;
+		if( res < 0 )
+		{
+			if( errno == EINTR )
+				continue;
+			if( http_client_would_block() )
+			{
+				http_client_result wait_res = http_client_wait_socket( client, true );
+				if( wait_res != HTTP_CLIENT_OK )
+					return wait_res;
+				continue;
+			}
+			// ... fd do not support sendfile, fall back to read()/send() ...
+			if( ( errno == EINVAL || errno == ENOSYS || errno == ESPIPE ) && (size_t)off == offset )
+				break;
+			return HTTP_CLIENT_SOCKET_ERROR;
+		}
+		if( res == 0 )
+			return HTTP_CLIENT_FILE_ERROR; // ... file is shorter than size ...
+		size -= (size_t)res;
+		client->stats.bytes_sent += (size_t)res;
+	}
+	if( size == 0 )
+		return HTTP_CLIENT_OK;
+#endif
+
+	char buffer[16 * 1024];
+	while( size > 0 )
+	{
+		size_t to_read = size < sizeof( buffer ) ? size : sizeof( buffer );
+#if defined( _MSC_VER )
+		if( _lseeki64( fd, (__int64)offset, SEEK_SET ) < 0 )
+			return HTTP_CLIENT_FILE_ERROR;
+		int res = _read( fd, buffer, (unsigned int)to_read );
+#else
+		ssize_t res = pread( fd, buffer, to_read, (off_t)offset );
+#endif
+		if( res < 0 && errno == EINTR )
+			continue;
+		if( res <= 0 )
+			return HTTP_CLIENT_FILE_ERROR;
+
+		http_client_iovec iov;
+		http_client_iov_set( &iov, buffer, (size_t)res );
+		http_client_result send_res = http_client_sendv_all( client, &iov, 1 );
+		if( send_res != HTTP_CLIENT_OK )
+			return send_res;
+		offset += (size_t)res;
+		size   -= (size_t)res;
+	}
+	return HTTP_CLIENT_OK;
+}
+
+/**
+ * Pull the body from producer and send it as chunks, each chunk with its framing in one syscall.
+ */
+static http_client_result http_client_send_chunked( http_client_t client, http_client_body_producer producer, void* userdata )
+{
+	char data[16 * 1024];
+	while( true )
+	{
+		size_t produced = 0;
+		if( producer( data, sizeof( data ), &produced, userdata ) != 0 )
+			return HTTP_CLIENT_ABORTED;
+		if( produced > sizeof( data ) )
+			return HTTP_CLIENT_INTERNAL_ERROR;
+
+		if( produced == 0 )
+		{
+			// ... last-chunk and end of the empty trailer-section ...
+			http_client_iovec iov;
+			http_client_iov_set( &iov, "0\r\n\r\n", 5 );
+			return http_client_sendv_all( client, &iov, 1 );
+		}
+
+		char chunk_size[32];
+		int chunk_size_len = snprintf( chunk_size, sizeof( chunk_size ), "%lx\r\n", (unsigned long)produced );
+
+		http_client_iovec iov[3];
+		http_client_iov_set( &iov[0], chunk_size, (size_t)chunk_size_len );
+		http_client_iov_set( &iov[1], data, produced );
+		http_client_iov_set( &iov[2], "\r\n", 2 );
+		http_client_result res = http_client_sendv_all( client, iov, 3 );
+		if( res != HTTP_CLIENT_OK )
+			return res;
+	}
+}
+
+static http_client_result http_client_send_request( http_client_t client, const char* verb, const char* resource, const char* headers, const http_request_body* body )
+{
+	size_t content_length = HTTP_CLIENT_NO_BODY;
+	if( body )
+		content_length = body->producer ? HTTP_CLIENT_CHUNKED_BODY : body->size;
+
+	char request[2048];
+	int request_len = http_client_format_request( request, sizeof( request ), verb, resource, client->url->host, client->useragent, content_length, headers );
+	if( request_len < 0 || (size_t)request_len >= sizeof( request ) )
+		return HTTP_CLIENT_INTERNAL_ERROR;
+
+	// ... headers and in-memory payload in one syscall ...
+	http_client_iovec iov[2];
+	int iov_count = 1;
+	http_client_iov_set( &iov[0], request, (size_t)request_len );
+	if( body && body->data )
+		http_client_iov_set( &iov[iov_count++], body->data, body->size );
+
+	http_client_result res = http_client_sendv_all( client, iov, iov_count );
+	if( res != HTTP_CLIENT_OK || body == 0x0 || body->data != 0x0 )
+		return res;
+	if( body->producer )
+		return http_client_send_chunked( client, body->producer, body->userdata );
+	return http_client_send_file( client, body->fd, body->offset, body->size );
+}
+
+/**
+ * Read and parse header lines up until the empty line ending the header block. All buffered lines are found in one
+ * pass by http_client_scan_lines() and parsed in place.
+ *
+ * The header block is kept in the receive buffer, with the headers in client->headers pointing into it, until the
+ * next response is read.
+ */
+static http_client_result http_client_read_headers( http_client_t client, http_request_ctx* ctx, const char* verb, http_response* response )
+{
+	client->num_headers = 0;
+	memset( client->known_headers, 0x0, sizeof( client->known_headers ) );
+
+	size_t num_headers = 0;
+	size_t head_start = ctx->read_pos;
+	while( true )
+	{
+		http_scan_line lines[32];
+		size_t consumed = 0;
+		char* block = ctx->buffer + ctx->read_pos;
+		size_t num_lines = http_client_scan_lines( block, http_client_ctx_buffered( ctx ), lines, sizeof( lines ) / sizeof( lines[0] ), &consumed );
+
+		for( size_t i = 0; i < num_lines; ++i )
+		{
+			const http_scan_line* line = &lines[i];
+			block[line->end] = '\0';
+			if( line->end == line->start )
+			{
+				// ... keep the header block in place for as long as the response is processed ...
+				ctx->base = ctx->read_pos + consumed;
+				http_client_ctx_consume( ctx, consumed );
+				client->num_headers = num_headers;
+				http_client_response_headers_done( response, verb );
+				return HTTP_CLIENT_OK;
+			}
+
+			if( line->colon == line->end )
+				continue; // ... not a header, ignore ...
+
+			char* name  = block + line->start;
+			char* value = block + line->colon + 1;
+			char* value_end = block + line->end;
+			while( value < value_end && ( *value == ' ' || *value == '\t' ) )
+				++value;
+			while( value_end > value && ( value_end[-1] == ' ' || value_end[-1] == '\t' ) )
+				--value_end;
+			*value_end = '\0';
+
+			size_t name_len = line->colon - line->start;
+			HTTP_CLIENT_HOOK( client, header, ( name, name_len, value, (size_t)( value_end - value ), client->hooks_userdata ) );
+
+			http_client_header_id id = http_client_classify_header( name, name_len );
+			http_client_parse_header( response, id, value );
+
+			if( num_headers < HTTP_CLIENT_MAX_HEADERS )
+			{
+				if( id != HTTP_CLIENT_HEADER_UNKNOWN && client->known_headers[id] == 0 )
+					client->known_headers[id] = (unsigned char)( num_headers + 1 );
+
+				name[name_len] = '\0';
+				http_client_header* header = &client->headers[num_headers++];
+				header->name      = name;
+				header->name_len  = name_len;
+				header->value     = value;
+				header->value_len = (size_t)( value_end - value );
+			}
+		}
+		// ... parsed lines are part of the header block and may not be overwritten ...
+		ctx->base = ctx->read_pos + consumed;
+		http_client_ctx_consume( ctx, consumed );
+
+		// ... lines was not filled so all buffered lines are parsed, receive more ...
+		if( num_lines < sizeof( lines ) / sizeof( lines[0] ) )
+		{
+			if( ctx->write_pos == ctx->buffer_size && head_start > 0 )
+			{
+				// ... make room by moving the header block, parsed and unparsed, to the start of the buffer ...
+				ctx->base = 0;
+				http_client_ctx_compact( ctx, head_start, 0 );
+				for( size_t i = 0; i < num_headers; ++i )
+				{
+					client->headers[i].name  -= head_start;
+					client->headers[i].value -= head_start;
+				}
+				ctx->base = ctx->read_pos;
+				head_start = 0;
+			}
+
+			http_client_result res = http_client_ctx_fill( client->sockfd, ctx );
+			if( res != HTTP_CLIENT_OK )
+				return res;
+		}
+	}
+}
+
+/**
+ * Read status-line and headers of the next response on client to a request with verb, informational 1xx responses are
+ * skipped.
+ */
+static http_client_result http_client_read_response_head( http_client_t client, http_request_ctx* ctx, const char* verb, http_response* response )
+{
+	http_client_result res;
+	do
+	{
+		// ... header block of the previous response is no longer needed ...
+		ctx->base = 0;
+
+		unsigned int protocol_major = 1;
+		unsigned int protocol_minor = 1;
+		unsigned int status = 0;
+		res = http_client_read_status_line( client->sockfd, ctx, &protocol_major, &protocol_minor, &status );
+		if( res != HTTP_CLIENT_OK )
+			return res;
+		HTTP_CLIENT_HOOK( client, status, ( status, client->hooks_userdata ) );
+
+		http_client_response_init( response, protocol_major, protocol_minor, status );
+		res = http_client_read_headers( client, ctx, verb, response );
+	} while( res == HTTP_CLIENT_OK && response->status >= 100 && response->status < 200 );
+
+	if( res == HTTP_CLIENT_OK )
+		client->stats.headers_done = http_client_time_us();
+	return res;
+}
+
+/**
+ * Make sure client has a usable connection, reconnect if it was closed or the server closed it while idle.
+ */
+static http_client_result http_client_ensure_connection( http_client_t client )
+{
+	if( client->sockfd >= 0 && client->socket_uses > 0 && !http_client_socket_alive( client->sockfd ) )
+		http_client_drop_connection( client );
+
+	if( client->sockfd < 0 )
+		return http_client_open_socket( client );
+	HTTP_CLIENT_HOOK( client, connection, ( HTTP_CLIENT_CONNECTION_REUSED, client->hooks_userdata ) );
+	return HTTP_CLIENT_OK;
+}
+
+static http_client_result http_client_make_request( http_client_t client, http_request_ctx* ctx, const char* verb, const char* resource, const char* headers, const http_request_body* body, http_response* response )
+{
+	for( int attempt = 0; ; ++attempt )
+	{
+		http_client_result res = http_client_ensure_connection( client );
+		if( res != HTTP_CLIENT_OK )
+			return res;
+
+		bool reused = client->socket_uses > 0;
+		++client->socket_uses;
+
+		http_client_ctx_init( ctx, client );
+
+		res = http_client_send_request( client, verb, resource, headers, body );
+		if( res == HTTP_CLIENT_OK )
+		{
+			client->stats.request_sent = http_client_time_us();
+			res = http_client_read_response_head( client, ctx, verb, response );
+		}
+		if( res == HTTP_CLIENT_OK )
+			return HTTP_CLIENT_OK;
+
+		http_client_drop_connection( client );
+
+		// ... a reused connection might have been closed by the server while we were sending, retry once on a new one.
+		//     A body pulled from a producer can not be replayed so that is never retried ...
+		bool replayable = body == 0x0 || body->producer == 0x0;
+		if( reused && replayable && attempt == 0 && ctx->bytes_read == 0 && ( res == HTTP_CLIENT_CONNECTION_LOST || res == HTTP_CLIENT_SOCKET_ERROR ) )
+		{
+			++client->stats.retries;
+			continue;
+		}
+		return res;
+	}
+}
+
+static http_client_result http_client_sink_write( http_body_sink* sink, const void* data, size_t size )
+{
+	if( sink == 0x0 )
+		return HTTP_CLIENT_OK;
+	return sink->write( sink, data, size );
+}
+
+/**
+ * Read bytes of message body to sink, first from what is already buffered in ctx then from the socket.
+ * If until_eof is set the server closing the connection is a valid end of the body.
+ */
+static http_client_result http_client_read_body_bytes( int sockfd, http_request_ctx* ctx, http_body_sink* sink, size_t bytes, bool until_eof )
+{
+	char scratch[512];
+
+	size_t buffered = http_client_ctx_buffered( ctx );
+	size_t from_buffer = bytes < buffered ? bytes : buffered;
+	if( from_buffer > 0 )
+	{
+		HTTP_CLIENT_HOOK( ctx->client, body_chunk, ( ctx->buffer + ctx->read_pos, from_buffer, ctx->client->hooks_userdata ) );
+		http_client_result res = http_client_sink_write( sink, ctx->buffer + ctx->read_pos, from_buffer );
+		http_client_ctx_consume( ctx, from_buffer );
+		if( res != HTTP_CLIENT_OK )
+			return res;
+		bytes -= from_buffer;
+	}
+
+	while( bytes > 0 )
+	{
+		size_t avail = 0;
+		void* dst = 0x0;
+		if( sink != 0x0 && sink->reserve != 0x0 )
+		{
+			http_client_result res = sink->reserve( sink, bytes, &dst, &avail );
+			if( res != HTTP_CLIENT_OK )
+				return res;
+		}
+		else
+		{
+			// ... ctx is empty, and so rewound to base, here since all buffered bytes were consumed above ...
+			dst = ctx->buffer + ctx->base;
+			avail = ctx->buffer_size - ctx->base;
+			if( avail == 0 )
+			{
+				// ... header block filled the buffer ...
+				dst = scratch;
+				avail = sizeof( scratch );
+			}
+		}
+		if( avail > bytes )
+			avail = bytes;
+
+		size_t bytes_read = 0;
+		http_client_result res = http_client_ctx_recv( sockfd, ctx, dst, avail, &bytes_read );
+		if( res != HTTP_CLIENT_OK )
+			return res;
+		if( bytes_read == 0 )
+			return until_eof ? HTTP_CLIENT_OK : HTTP_CLIENT_CONNECTION_LOST;
+
+		HTTP_CLIENT_HOOK( ctx->client, body_chunk, ( dst, bytes_read, ctx->client->hooks_userdata ) );
+		res = http_client_sink_write( sink, dst, bytes_read );
+		if( res != HTTP_CLIENT_OK )
+			return res;
+		bytes -= bytes_read;
+	}
+
+	return HTTP_CLIENT_OK;
+}
+
+static http_client_result http_client_read_chunk_size( int sockfd, http_request_ctx* ctx, size_t* chunk_size )
+{
+	while( true )
+	{
+		char* line;
+		http_client_result res = http_client_readline( sockfd, ctx, &line );
+		if( res != HTTP_CLIENT_OK )
+			return res;
+
+		// ... check and ignore empty lines ...
+		if( line[0] != 0 )
+		{
+			*chunk_size = http_client_parse_chunk_size( line );
+			return HTTP_CLIENT_OK;
+		}
+	}
+
+	return HTTP_CLIENT_OK;
+}
+
+/**
+ * Read the message body of response, as framed by chunked encoding or content-length, to sink. A sink of NULL will
+ * just discard the body.
+ */
+static http_client_result http_client_read_framed_body( http_client_t client, http_request_ctx* ctx, const http_response* response, http_body_sink* sink )
+{
+	if( sink != 0x0 && sink->begin != 0x0 )
+	{
+		http_client_result res = sink->begin( sink, response );
+		if( res != HTTP_CLIENT_OK )
+			return res;
+	}
+
+	if( response->chunked )
+	{
+		while( true )
+		{
+			size_t chunk_size;
+			http_client_result res = http_client_read_chunk_size( client->sockfd, ctx, &chunk_size );
+			if( res != HTTP_CLIENT_OK )
+				return res;
+
+			if( chunk_size == 0 )
+				break;
+
+			res = http_client_read_body_bytes( client->sockfd, ctx, sink, chunk_size, false );
+			if( res != HTTP_CLIENT_OK )
+				return res;
+		}
+
+		// ... skip trailers up until the terminating empty line ...
+		while( true )
+		{
+			char* line;
+			http_client_result res = http_client_readline( client->sockfd, ctx, &line );
+			if( res != HTTP_CLIENT_OK )
+				return res;
+			if( line[0] == '\0' )
+				return HTTP_CLIENT_OK;
+		}
+	}
+
+	if( response->has_content_length )
+		return http_client_read_body_bytes( client->sockfd, ctx, sink, response->content_length, false );
+
+	return http_client_read_body_bytes( client->sockfd, ctx, sink, (size_t)-1, true );
+}
+
+/**
+ * Sink decompressing a content-coded body and passing the result on to another sink.
+ */
+struct http_decode_sink
+{
+	http_body_sink sink;
+	http_body_sink* inner;
+	http_decoder* decoder;
+};
+
+static http_client_result http_decode_sink_begin( http_body_sink* self, const http_response* response )
+{
+	http_decode_sink* s = (http_decode_sink*)self;
+	if( s->inner->begin == 0x0 )
+		return HTTP_CLIENT_OK;
+
+	// ... content-length is the size of the encoded body, the decoded size is not known ...
+	http_response decoded = *response;
+	decoded.has_content_length = false;
+	decoded.content_length = 0;
+	return s->inner->begin( s->inner, &decoded );
+}
+
+static http_client_result http_decode_sink_write( http_body_sink* self, const void* data, size_t size )
+{
+	http_decode_sink* s = (http_decode_sink*)self;
+	char scratch[16 * 1024];
+
+	while( true )
+	{
+		void* dst = 0x0;
+		size_t avail = 0;
+		// ... a failing reserve() might just mean that no more output fits, that is only an error if there is more output ...
+		if( s->inner->reserve == 0x0 || s->inner->reserve( s->inner, sizeof( scratch ), &dst, &avail ) != HTTP_CLIENT_OK || avail == 0 )
+		{
+			dst = scratch;
+			avail = sizeof( scratch );
+		}
+
+		size_t in_before = size;
+		size_t produced = 0;
+		http_client_result res = http_client_decoder_run( s->decoder, &data, &size, dst, avail, &produced );
+		if( res != HTTP_CLIENT_OK )
+			return res;
+
+		if( produced > 0 )
+		{
+			res = s->inner->write( s->inner, dst, produced );
+			if( res != HTTP_CLIENT_OK )
+				return res;
+		}
+
+		// ... a filled output might mean that the decoder has more output buffered ...
+		if( size == 0 && ( produced < avail || http_client_decoder_done( s->decoder ) ) )
+			return HTTP_CLIENT_OK;
+		if( produced == 0 && size == in_before )
+			return HTTP_CLIENT_DECODE_ERROR;
+	}
+}
+
+/**
+ * Read the message body of response to sink, decompressing it if it is encoded with one of the codings enabled on
+ * client. A sink of NULL will just discard the body.
+ */
+static http_client_result http_client_read_body( http_client_t client, http_request_ctx* ctx, const http_response* response, http_body_sink* sink )
+{
+	if( sink == 0x0 || ( response->content_encoding & client->decode_encodings ) == 0 )
+		return http_client_read_framed_body( client, ctx, response, sink );
+
+	http_client_result res = http_client_decoder_begin( &client->decoder, response->content_encoding );
+	if( res != HTTP_CLIENT_OK )
+		return res;
+
+	http_decode_sink decode = { { http_decode_sink_begin, 0x0, http_decode_sink_write }, sink, client->decoder };
+	res = http_client_read_framed_body( client, ctx, response, &decode.sink );
+	if( res == HTTP_CLIENT_OK && !http_client_decoder_done( client->decoder ) )
+		return HTTP_CLIENT_DECODE_ERROR; // ... body ended in the middle of the encoded stream ...
+	return res;
+}
+
+/**
+ * Send a request with the extra header block headers and receive the response on client, body of the response is
+ * written to sink or discarded if the request failed. When done the connection is either ready for the next request
+ * or closed.
+ */
+static http_client_result http_client_exchange( http_client_t client, const char* verb, const char* resource, const char* headers, const http_request_body* body, http_body_sink* sink, http_response* response )
+{
+	http_request_ctx ctx;
+	http_client_ctx_init( &ctx, client );
+
+	http_client_result res = http_client_make_request( client, &ctx, verb, resource, headers, body, response );
+	if( res != HTTP_CLIENT_OK )
+	{
+		HTTP_CLIENT_HOOK( client, error, ( res, client->hooks_userdata ) );
+		return res;
+	}
+
+	bool success = response->status < 300;
+	if( http_client_response_has_body( verb, response->status ) )
+		res = http_client_read_body( client, &ctx, response, success ? sink : 0x0 );
+
+	client->stats.body_done = http_client_time_us();
+
+	// ... anything left in the buffer belongs to no request we made, can't reuse the connection ...
+	if( res != HTTP_CLIENT_OK || !response->keep_alive || http_client_ctx_buffered( &ctx ) != 0 )
+		http_client_drop_connection( client );
+
+	if( res != HTTP_CLIENT_OK )
+	{
+		HTTP_CLIENT_HOOK( client, error, ( res, client->hooks_userdata ) );
+		return res;
+	}
+
+	return success ? HTTP_CLIENT_OK : (http_client_result)response->status;
+}
+
+http_client_result http_client_request( http_client_t client, const char* verb, const char* resource, const char* headers, http_body_sink* sink, http_response* response )
+{
+	http_client_call_begin( client );
+	HTTP_CLIENT_HOOK( client, request_start, ( verb, resource, client->hooks_userdata ) );
+	return http_client_exchange( client, verb, resource, headers, 0x0, sink, response );
+}
+
+/**
+ * Sink keeping a copy of the body passed on to another sink, to be stored in the response cache.
+ */
+struct http_cache_sink
+{
+	http_body_sink sink;
+	http_body_sink* inner;
+	http_client_t client;
+	bool store;                  ///< response is to be stored, cleared if the body turns out to be too large.
+	unsigned long long lifetime;
+	size_t max_size;
+	char*  body;
+	size_t size;
+	size_t capacity;
+};
+
+static http_client_result http_cache_sink_begin( http_body_sink* self, const http_response* response )
+{
+	http_cache_sink* s = (http_cache_sink*)self;
+	s->store = response->status == 200 && http_client_cache_policy( s->client, response, &s->lifetime, &s->max_size );
+	if( s->store && response->has_content_length && !response->chunked && response->content_encoding == 0 && response->content_length > s->max_size )
+		s->store = false;
+	return s->inner->begin ? s->inner->begin( s->inner, response ) : HTTP_CLIENT_OK;
+}
+
+static http_client_result http_cache_sink_reserve( http_body_sink* self, size_t size, void** dst, size_t* avail )
+{
+	http_cache_sink* s = (http_cache_sink*)self;
+	return s->inner->reserve( s->inner, size, dst, avail );
+}
+
+static http_client_result http_cache_sink_write( http_body_sink* self, const void* data, size_t size )
+{
+	http_cache_sink* s = (http_cache_sink*)self;
+	http_client_result res = s->inner->write( s->inner, data, size );
+	if( res != HTTP_CLIENT_OK || !s->store )
+		return res;
+
+	if( s->size + size > s->max_size )
+	{
+		s->store = false;
+		return HTTP_CLIENT_OK;
+	}
+
+	if( s->size + size > s->capacity )
+	{
+		size_t capacity = s->capacity < 4096 ? 4096 : s->capacity * 2;
+		while( capacity < s->size + size )
+			capacity *= 2;
+		char* body = (char*)realloc( s->body, capacity );
+		if( body == 0x0 )
+		{
+			s->store = false; // ... the cache is best effort, the call itself can still succeed ...
+			return HTTP_CLIENT_OK;
+		}
+		s->body = body;
+		s->capacity = capacity;
+	}
+	memcpy( s->body + s->size, data, size );
+	s->size += size;
+	return HTTP_CLIENT_OK;
+}
+
+/**
+ * Pass a cached response to sink as if it was received, including its headers.
+ */
+static http_client_result http_client_cache_serve( http_client_t client, const http_cache_entry* entry, http_body_sink* sink, http_response* response )
+{
+	memset( response, 0x0, sizeof( http_response ) );
+	response->status = 200;
+	response->content_length = entry->body_size;
+	response->has_content_length = true;
+	response->keep_alive = true;
+	http_client_cache_restore_headers( client, entry );
+
+	http_client_result res = HTTP_CLIENT_OK;
+	if( sink && sink->begin )
+		res = sink->begin( sink, response );
+	if( res == HTTP_CLIENT_OK && sink && entry->body_size > 0 )
+		res = sink->write( sink, entry->body, entry->body_size );
+
+	client->stats.body_done = http_client_time_us();
+	if( res != HTTP_CLIENT_OK )
+		HTTP_CLIENT_HOOK( client, error, ( res, client->hooks_userdata ) );
+	return res;
+}
+
+/**
+ * GET resource through the response cache of client. Fresh responses are served from the cache, stale ones are
+ * revalidated with a conditional request and anything else is fetched and stored if allowed.
+ */
+static http_client_result http_client_perform_cached( http_client_t client, const char* resource, http_body_sink* sink, http_response* response )
+{
+	bool fresh = false;
+	http_cache_entry* entry = http_client_cache_lookup( client->cache, client, resource, &fresh );
+	if( entry && fresh )
+	{
+		http_client_result res = http_client_cache_serve( client, entry, sink, response );
+		http_client_cache_release( client->cache, entry );
+		return res;
+	}
+
+	char headers[1024];
+	const char* request_headers = client->accept_encoding;
+	if( entry )
+	{
+		int len = snprintf( headers, sizeof( headers ), "%s", client->accept_encoding );
+		if( entry->etag && len >= 0 && (size_t)len < sizeof( headers ) )
+			len += snprintf( headers + len, sizeof( headers ) - (size_t)len, "If-None-Match: %s\r\n", entry->etag );
+		if( entry->last_modified && len >= 0 && (size_t)len < sizeof( headers ) )
+			len += snprintf( headers + len, sizeof( headers ) - (size_t)len, "If-Modified-Since: %s\r\n", entry->last_modified );
+		if( len >= 0 && (size_t)len < sizeof( headers ) )
+			request_headers = headers;
+	}
+
+	http_cache_sink cache_sink = { { http_cache_sink_begin, 0x0, http_cache_sink_write }, sink, client, false, 0, 0, 0x0, 0, 0 };
+	if( sink && sink->reserve )
+		cache_sink.sink.reserve = http_cache_sink_reserve;
+
+	http_client_result res = http_client_exchange( client, "GET", resource, request_headers, 0x0, sink ? &cache_sink.sink : 0x0, response );
+	if( res == HTTP_CLIENT_RESULT_304_NOT_MODIFIED && entry && request_headers == headers )
+	{
+		// ... the 304 carries the current caching headers of the stored response ...
+		unsigned long long lifetime;
+		size_t max_size;
+		if( !http_client_cache_policy( client, response, &lifetime, &max_size ) )
+			lifetime = 0;
+		http_client_cache_refresh( client->cache, entry, lifetime );
+		res = http_client_cache_serve( client, entry, sink, response );
+	}
+	else if( res == HTTP_CLIENT_OK && cache_sink.store )
+	{
+		bool decoded = ( response->content_encoding & client->decode_encodings ) != 0;
+		http_client_cache_store( client->cache, client, resource, cache_sink.lifetime, cache_sink.body, cache_sink.size, decoded );
+		cache_sink.body = 0x0;
+	}
+
+	free( cache_sink.body );
+	if( entry )
+		http_client_cache_release( client->cache, entry );
+	return res;
+}
+
+/**
+ * Perform a full request/response on client, through the response cache for GETs if client has one.
+ */
+static http_client_result http_client_perform( http_client_t client, const char* verb, const char* resource, const http_request_body* body, http_body_sink* sink, http_response* response )
+{
+	http_client_call_begin( client );
+	HTTP_CLIENT_HOOK( client, request_start, ( verb, resource, client->hooks_userdata ) );
+
+	if( client->cache == 0x0 )
+		return http_client_exchange( client, verb, resource, client->accept_encoding, body, sink, response );
+	if( body == 0x0 && strcmp( verb, "GET" ) == 0 )
+		return http_client_perform_cached( client, resource, sink, response );
+
+	// ... a successful unsafe request invalidates the cached response of its resource, rfc 9111 section 4.4 ...
+	http_client_result res = http_client_exchange( client, verb, resource, client->accept_encoding, body, sink, response );
+	if( res == HTTP_CLIENT_OK && strcmp( verb, "HEAD" ) != 0 )
+		http_client_cache_invalidate( client->cache, client, resource );
+	return res;
+}
+
+struct http_alloc_sink
+{
+	http_body_sink sink;
+	http_client_allocator* alloc;
+	void** msgbody;
+	size_t* msgbody_size;
+	size_t capacity;
+	bool until_eof;
+};
+
+static bool http_alloc_sink_grow( http_alloc_sink* s, size_t capacity )
+{
+	void* mem = http_client_alloc( *s->msgbody, capacity, s->alloc );
+	if( mem == 0x0 )
+		return false;
+	*s->msgbody = mem;
+	s->capacity = capacity;
+	return true;
+}
+
+static http_client_result http_alloc_sink_begin( http_body_sink* self, const http_response* response )
+{
+	http_alloc_sink* s = (http_alloc_sink*)self;
+	s->until_eof = !response->chunked && !response->has_content_length;
+	if( response->chunked || !response->has_content_length || response->content_length == 0 )
+		return HTTP_CLIENT_OK;
+	return http_alloc_sink_grow( s, response->content_length ) ? HTTP_CLIENT_OK : HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+}
+
+static http_client_result http_alloc_sink_reserve( http_body_sink* self, size_t size, void** dst, size_t* avail )
+{
+	http_alloc_sink* s = (http_alloc_sink*)self;
+	if( s->capacity == *s->msgbody_size )
+	{
+		// ... size is unknown for chunked or eof-delimited bodies, grow geometrically to not copy the body once per chunk ...
+		size_t grow = s->capacity < 4096 ? 4096 : s->capacity;
+		if( !s->until_eof && size > grow )
+			grow = size;
+		if( !http_alloc_sink_grow( s, s->capacity + grow ) )
+			return HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+	}
+	*dst   = (char*)*s->msgbody + *s->msgbody_size;
+	*avail = s->capacity - *s->msgbody_size;
+	return HTTP_CLIENT_OK;
+}
+
+static http_client_result http_alloc_sink_write( http_body_sink* self, const void* data, size_t size )
+{
+	http_alloc_sink* s = (http_alloc_sink*)self;
+	char* dst = (char*)*s->msgbody + *s->msgbody_size;
+	if( data != dst )
+	{
+		size_t needed = *s->msgbody_size + size;
+		if( s->capacity < needed && !http_alloc_sink_grow( s, needed > s->capacity * 2 ? needed : s->capacity * 2 ) )
+			return HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+		memcpy( (char*)*s->msgbody + *s->msgbody_size, data, size );
+	}
+	*s->msgbody_size += size;
+	return HTTP_CLIENT_OK;
+}
+
+size_t http_client_response_headers( http_client_t client, const http_client_header** headers )
+{
+	*headers = client->headers;
+	return client->num_headers;
+}
+
+const http_client_header* http_client_get_header( http_client_t client, http_client_header_id id )
+{
+	if( (unsigned int)id >= HTTP_CLIENT_HEADER_KNOWN_COUNT || client->known_headers[id] == 0 )
+		return 0x0;
+	return &client->headers[client->known_headers[id] - 1];
+}
+
+const http_client_header* http_client_find_header( http_client_t client, const char* name )
+{
+	size_t name_len = strlen( name );
+	http_client_header_id id = http_client_classify_header( name, name_len );
+	if( id != HTTP_CLIENT_HEADER_UNKNOWN )
+		return http_client_get_header( client, id );
+
+	for( size_t i = 0; i < client->num_headers; ++i )
+	{
+		const http_client_header* header = &client->headers[i];
+		if( header->name_len == name_len && strncasecmp( header->name, name, name_len ) == 0 )
+			return header;
+	}
+	return 0x0;
+}
+
+http_client_result http_client_get( http_client_t client, const char* resource, void** msgbody, size_t* msgbody_size, http_client_allocator* alloc )
+{
+	*msgbody = 0x0;
+	*msgbody_size = 0;
+
+	http_alloc_sink sink = { { http_alloc_sink_begin, http_alloc_sink_reserve, http_alloc_sink_write }, alloc, msgbody, msgbody_size, 0, false };
+	http_response response;
+	return http_client_perform( client, "GET", resource, 0x0, &sink.sink, &response );
+}
+
+struct http_buffer_sink
+{
+	http_body_sink sink;
+	char* buffer;
+	size_t capacity;
+	size_t* size;
+};
+
+static http_client_result http_buffer_sink_begin( http_body_sink* self, const http_response* response )
+{
+	http_buffer_sink* s = (http_buffer_sink*)self;
+	if( response->has_content_length && !response->chunked && response->content_length > s->capacity )
+		return HTTP_CLIENT_BUFFER_TOO_SMALL;
+	return HTTP_CLIENT_OK;
+}
+
+static http_client_result http_buffer_sink_reserve( http_body_sink* self, size_t, void** dst, size_t* avail )
+{
+	// ... a full buffer with more body to come, for an eof-delimited body this is reported even if the server is just about to close ...
+	http_buffer_sink* s = (http_buffer_sink*)self;
+	if( *s->size == s->capacity )
+		return HTTP_CLIENT_BUFFER_TOO_SMALL;
+	*dst   = s->buffer + *s->size;
+	*avail = s->capacity - *s->size;
+	return HTTP_CLIENT_OK;
+}
+
+static http_client_result http_buffer_sink_write( http_body_sink* self, const void* data, size_t size )
+{
+	http_buffer_sink* s = (http_buffer_sink*)self;
+	if( data != s->buffer + *s->size )
+	{
+		if( s->capacity - *s->size < size )
+			return HTTP_CLIENT_BUFFER_TOO_SMALL;
+		memcpy( s->buffer + *s->size, data, size );
+	}
+	*s->size += size;
+	return HTTP_CLIENT_OK;
+}
+
+http_client_result http_client_get_into( http_client_t client, const char* resource, void* buffer, size_t buffer_size, size_t* msgbody_size )
+{
+	*msgbody_size = 0;
+	http_buffer_sink sink = { { http_buffer_sink_begin, http_buffer_sink_reserve, http_buffer_sink_write }, (char*)buffer, buffer_size, msgbody_size };
+	http_response response;
+	return http_client_perform( client, "GET", resource, 0x0, &sink.sink, &response );
+}
+
+struct http_callback_sink
+{
+	http_body_sink sink;
+	http_client_body_callback callback;
+	void* userdata;
+};
+
+static http_client_result http_callback_sink_write( http_body_sink* self, const void* data, size_t size )
+{
+	http_callback_sink* s = (http_callback_sink*)self;
+	return s->callback( data, size, s->userdata ) == 0 ? HTTP_CLIENT_OK : HTTP_CLIENT_ABORTED;
+}
+
+http_client_result http_client_get_stream( http_client_t client, const char* resource, http_client_body_callback callback, void* userdata )
+{
+	// ... no reserve(), body is received into the request buffer and passed to callback from there ...
+	http_callback_sink sink = { { 0x0, 0x0, http_callback_sink_write }, callback, userdata };
+	http_response response;
+	return http_client_perform( client, "GET", resource, 0x0, &sink.sink, &response );
+}
+
+http_client_result http_client_head( http_client_t client, const char* resource, size_t* msgbody_size )
+{
+	*msgbody_size = 0;
+	http_response response;
+	http_client_result res = http_client_perform( client, "HEAD", resource, 0x0, 0x0, &response );
+	if( res == HTTP_CLIENT_OK && response.has_content_length )
+		*msgbody_size = response.content_length;
+	return res;
+}
+
+http_client_result http_client_post( http_client_t client, const char* resource, const void* msgbody, size_t msgbody_size )
+{
+	http_request_body body = { msgbody, msgbody_size, -1, 0, 0x0, 0x0 };
+	http_response response;
+	return http_client_perform( client, "POST", resource, &body, 0x0, &response );
+}
+
+http_client_result http_client_put( http_client_t client, const char* resource, const void* msgbody, size_t msgbody_size )
+{
+	http_request_body body = { msgbody, msgbody_size, -1, 0, 0x0, 0x0 };
+	http_response response;
+	return http_client_perform( client, "PUT", resource, &body, 0x0, &response );
+}
+
+http_client_result http_client_post_file( http_client_t client, const char* resource, int fd, size_t offset, size_t size )
+{
+	http_request_body body = { 0x0, size, fd, offset, 0x0, 0x0 };
+	http_response response;
+	return http_client_perform( client, "POST", resource, &body, 0x0, &response );
+}
+
+http_client_result http_client_put_file( http_client_t client, const char* resource, int fd, size_t offset, size_t size )
+{
+	http_request_body body = { 0x0, size, fd, offset, 0x0, 0x0 };
+	http_response response;
+	return http_client_perform( client, "PUT", resource, &body, 0x0, &response );
+}
+
+http_client_result http_client_post_chunked( http_client_t client, const char* resource, http_client_body_producer producer, void* userdata )
+{
+	http_request_body body = { 0x0, 0, -1, 0, producer, userdata };
+	http_response response;
+	return http_client_perform( client, "POST", resource, &body, 0x0, &response );
+}
+
+http_client_result http_client_put_chunked( http_client_t client, const char* resource, http_client_body_producer producer, void* userdata )
+{
+	http_request_body body = { 0x0, 0, -1, 0, producer, userdata };
+	http_response response;
+	return http_client_perform( client, "PUT", resource, &body, 0x0, &response );
+}
+
+http_client_result http_client_delete( http_client_t client, const char* resource )
+{
+	http_response response;
+	return http_client_perform( client, "DELETE", resource, 0x0, 0x0, &response );
+}
+
+static http_client_result http_client_pipeline_fail( http_client_t client, http_client_result res )
+{
+	http_client_drop_connection( client );
+	HTTP_CLIENT_HOOK( client, error, ( res, client->hooks_userdata ) );
+	return res;
+}
+
+/**
+ * Send requests back-to-back on the connection of client and read their responses in order.
+ * *completed is set to the number of requests, from the start of requests, that got a full response.
+ */
+static http_client_result http_client_pipeline_window( http_client_t client, http_client_pipeline_request* requests, size_t num_requests, http_client_allocator* alloc, size_t* completed )
+{
+	*completed = 0;
+
+	http_client_result res = http_client_ensure_connection( client );
+	if( res != HTTP_CLIENT_OK )
+		return res;
+
+	char buffer[4096];
+	size_t used = 0;
+	for( size_t i = 0; i < num_requests && res == HTTP_CLIENT_OK; ++i )
+	{
+		const http_client_pipeline_request* req = &requests[i];
+		HTTP_CLIENT_HOOK( client, request_start, ( req->verb, req->resource, client->hooks_userdata ) );
+		int len = http_client_format_request( buffer + used, sizeof( buffer ) - used, req->verb, req->resource, client->url->host, client->useragent, HTTP_CLIENT_NO_BODY, client->accept_encoding );
+		if( len >= 0 && (size_t)len >= sizeof( buffer ) - used && used > 0 )
+		{
+			// ... flush and retry on an empty buffer ...
+			http_client_iovec iov;
+			http_client_iov_set( &iov, buffer, used );
+			res = http_client_sendv_all( client, &iov, 1 );
+			used = 0;
+			len = http_client_format_request( buffer, sizeof( buffer ), req->verb, req->resource, client->url->host, client->useragent, HTTP_CLIENT_NO_BODY, client->accept_encoding );
+		}
+		if( len < 0 || (size_t)len >= sizeof( buffer ) - used )
+			res = HTTP_CLIENT_INTERNAL_ERROR;
+		else
+			used += (size_t)len;
+	}
+	if( res == HTTP_CLIENT_OK )
+	{
+		http_client_iovec iov;
+		http_client_iov_set( &iov, buffer, used );
+		res = http_client_sendv_all( client, &iov, 1 );
+	}
+	if( res != HTTP_CLIENT_OK )
+		return http_client_pipeline_fail( client, res );
+	client->stats.request_sent = http_client_time_us();
+	client->socket_uses += (unsigned int)num_requests;
+
+	http_request_ctx ctx;
+	http_client_ctx_init( &ctx, client );
+
+	for( size_t i = 0; i < num_requests; ++i )
+	{
+		http_client_pipeline_request* req = &requests[i];
+
+		http_response response;
+		res = http_client_read_response_head( client, &ctx, req->verb, &response );
+		if( res != HTTP_CLIENT_OK )
+			return http_client_pipeline_fail( client, res );
+
+		bool success = response.status < 300;
+		http_alloc_sink sink = { { http_alloc_sink_begin, http_alloc_sink_reserve, http_alloc_sink_write }, alloc, &req->msgbody, &req->msgbody_size, 0, false };
+		if( http_client_response_has_body( req->verb, response.status ) )
+			res = http_client_read_body( client, &ctx, &response, success ? &sink.sink : 0x0 );
+		if( res != HTTP_CLIENT_OK )
+			return http_client_pipeline_fail( client, res );
+
+		if( strcmp( req->verb, "HEAD" ) == 0 && response.has_content_length )
+			req->msgbody_size = response.content_length;
+		req->result = success ? HTTP_CLIENT_OK : (http_client_result)response.status;
+		++*completed;
+
+		// ... server will not answer the rest of the requests on this connection ...
+		if( !response.keep_alive )
+		{
+			http_client_drop_connection( client );
+			return HTTP_CLIENT_CONNECTION_LOST;
+		}
+	}
+
+	if( http_client_ctx_buffered( &ctx ) != 0 )
+		http_client_drop_connection( client );
+	return HTTP_CLIENT_OK;
+}
+
+http_client_result http_client_pipeline( http_client_t client, http_client_pipeline_request* requests, size_t num_requests, http_client_allocator* alloc )
+{
+	for( size_t i = 0; i < num_requests; ++i )
+	{
+		requests[i].msgbody = 0x0;
+		requests[i].msgbody_size = 0;
+		requests[i].result = HTTP_CLIENT_CONNECTION_LOST;
+	}
+
+	http_client_call_begin( client );
+
+	size_t done = 0;
+	while( done < num_requests )
+	{
+		size_t window = num_requests - done;
+		if( window > HTTP_CLIENT_PIPELINE_DEPTH )
+			window = HTTP_CLIENT_PIPELINE_DEPTH;
+
+		size_t completed = 0;
+		http_client_result res = http_client_pipeline_window( client, requests + done, window, alloc, &completed );
+		done += completed;
+		if( res != HTTP_CLIENT_OK )
+			break;
+	}
+
+	// ... the server closed the connection mid-pipeline, retry the requests that got no response one at a time ...
+	for( ; done < num_requests; ++done )
+	{
+		http_client_pipeline_request* req = &requests[done];
+		if( req->msgbody != 0x0 )
+			http_client_alloc( req->msgbody, 0, alloc );
+
+		http_client_stats batch = client->stats;
+		if( strcmp( req->verb, "HEAD" ) == 0 )
+			req->result = http_client_head( client, req->resource, &req->msgbody_size );
+		else
+			req->result = http_client_get( client, req->resource, &req->msgbody, &req->msgbody_size, alloc );
+		http_client_stats_merge( &batch, &client->stats );
+		client->stats = batch;
+	}
+	client->stats.body_done = http_client_time_us();
+
+	for( size_t i = 0; i < num_requests; ++i )
+		if( requests[i].result != HTTP_CLIENT_OK )
+			return requests[i].result;
+	return HTTP_CLIENT_OK;
 }
 
 const char* http_client_result_to_string( http_client_result result )
@@ -433,7 +2018,17 @@ const char* http_client_result_to_string( http_client_result result )
 		HTTP_RES_TO_STR( HTTP_CLIENT_UNSUPPORTED_SCHEME );
 		HTTP_RES_TO_STR( HTTP_CLIENT_SOCKET_ERROR ); // flesh out this.
 		HTTP_RES_TO_STR( HTTP_CLIENT_CONNECTION_LOST );
+		HTTP_RES_TO_STR( HTTP_CLIENT_MEMORY_ALLOC_ERROR );
 		HTTP_RES_TO_STR( HTTP_CLIENT_INTERNAL_ERROR );
+		HTTP_RES_TO_STR( HTTP_CLIENT_POOL_EXHAUSTED );
+		HTTP_RES_TO_STR( HTTP_CLIENT_NOT_SUPPORTED );
+		HTTP_RES_TO_STR( HTTP_CLIENT_ABORTED );
+		HTTP_RES_TO_STR( HTTP_CLIENT_BUFFER_TOO_SMALL );
+		HTTP_RES_TO_STR( HTTP_CLIENT_FILE_ERROR );
+		HTTP_RES_TO_STR( HTTP_CLIENT_CONNECT_TIMEOUT );
+		HTTP_RES_TO_STR( HTTP_CLIENT_READ_TIMEOUT );
+		HTTP_RES_TO_STR( HTTP_CLIENT_WRITE_TIMEOUT );
+		HTTP_RES_TO_STR( HTTP_CLIENT_DECODE_ERROR );
 
 		HTTP_RES_TO_STR( HTTP_CLIENT_RESULT_300_MULTIPLE_CHOICES );
 		HTTP_RES_TO_STR( HTTP_CLIENT_RESULT_301_MOVED_PERMANENTLY );
@@ -0,0 +1,600 @@
+/*
+    Simple http-client written to be an drop-in code, focus is to be small
+    and easy to use but maybe not efficient.
+
+    version 1.0, June, 2014
+
+	Copyright (C) 2014- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+#include <http_client/http_client_cache.h>
+#include "http_client_internal.h"
+#include "http_client_disk_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define HTTP_CACHE_BUCKETS 1024
+#define HTTP_CACHE_MAX_KEY 1024
+
+struct http_client_cache
+{
+	http_client_mutex mutex;
+	http_client_cache_config config;
+	http_client_cache_stats stats;
+	http_cache_entry* lru_head; ///< most recently used.
+	http_cache_entry* lru_tail; ///< least recently used, first to be evicted.
+	http_cache_entry* buckets[HTTP_CACHE_BUCKETS];
+	http_disk_cache* disk;      ///< persistent storage, all entries are stored here instead of in buckets if set.
+};
+
+/**
+ * Format the key of resource on the host of client, returns false if it does not fit. The url is normalized so that
+ * equivalent urls share an entry, the default port is explicit, the fragment is dropped and percent-encodings are in
+ * upper case. The host is already lower case from the url parser.
+ */
+static bool http_cache_make_key( http_client_t client, const char* resource, char* key, unsigned int* hash )
+{
+	unsigned int port = client->url->port == 0 ? 80 : client->url->port;
+	int len = snprintf( key, HTTP_CACHE_MAX_KEY, "%s:%u", client->url->host, port );
+	if( len <= 0 || len >= HTTP_CACHE_MAX_KEY )
+		return false;
+
+	size_t pos = (size_t)len;
+	if( *resource != '/' )
+		key[pos++] = '/';
+	for( const char* c = resource; *c && *c != '#'; ++c )
+	{
+		if( pos + 1 >= HTTP_CACHE_MAX_KEY )
+			return false;
+		bool in_escape = ( c > resource && c[-1] == '%' ) || ( c > resource + 1 && c[-2] == '%' );
+		key[pos++] = in_escape && *c >= 'a' && *c <= 'f' ? (char)( *c - 'a' + 'A' ) : *c;
+	}
+	key[pos] = '\0';
+
+	// ... fnv-1a ...
+	unsigned int h = 2166136261u;
+	for( const char* c = key; *c; ++c )
+		h = ( h ^ (unsigned char)*c ) * 16777619u;
+	*hash = h;
+	return true;
+}
+
+static http_cache_entry* http_cache_find( http_client_cache* cache, const char* key, unsigned int hash )
+{
+	for( http_cache_entry* entry = cache->buckets[hash % HTTP_CACHE_BUCKETS]; entry != 0x0; entry = entry->hash_next )
+		if( entry->hash == hash && strcmp( entry->key, key ) == 0 )
+			return entry;
+	return 0x0;
+}
+
+/**
+ * Find ETag and Last-Modified among the stored headers of entry.
+ */
+static void http_cache_index_headers( http_cache_entry* entry )
+{
+	const char* name = entry->headers;
+	for( size_t i = 0; i < entry->num_headers; ++i )
+	{
+		size_t name_len = strlen( name );
+		const char* value = name + name_len + 1;
+		http_client_header_id id = http_client_classify_header( name, name_len );
+		if( id == HTTP_CLIENT_HEADER_ETAG && entry->etag == 0x0 )
+			entry->etag = value;
+		else if( id == HTTP_CLIENT_HEADER_LAST_MODIFIED && entry->last_modified == 0x0 )
+			entry->last_modified = value;
+		name = value + strlen( value ) + 1;
+	}
+}
+
+/**
+ * Find key in the disk cache and wrap it in an entry pointing into the mapping, the record stays pinned until the
+ * entry is released. Expects cache to be locked.
+ */
+static http_cache_entry* http_cache_find_disk( http_client_cache* cache, const char* key, unsigned int hash )
+{
+	http_disk_view view;
+	if( !http_disk_cache_find( cache->disk, key, hash, &view ) )
+		return 0x0;
+
+	http_cache_entry* entry = (http_cache_entry*)malloc( sizeof( http_cache_entry ) );
+	if( entry == 0x0 )
+	{
+		http_disk_cache_unpin( cache->disk, view.offset );
+		return 0x0;
+	}
+
+	memset( entry, 0x0, sizeof( http_cache_entry ) );
+	entry->hash = hash;
+	entry->mapped = true;
+	entry->disk_offset = view.offset;
+	entry->key = view.key;
+	entry->headers = view.headers;
+	entry->headers_size = view.headers_size;
+	entry->num_headers = view.num_headers;
+	entry->body = (void*)view.body;
+	entry->body_size = view.body_size;
+
+	// ... expiry is stored as wall-clock time to survive restarts ...
+	long long fresh_for = view.expires - http_disk_cache_time();
+	entry->expires = http_client_time_ms() + (unsigned long long)( fresh_for > 0 ? fresh_for : 0 );
+	http_cache_index_headers( entry );
+	return entry;
+}
+
+static void http_cache_lru_unlink( http_client_cache* cache, http_cache_entry* entry )
+{
+	if( entry->lru_prev ) entry->lru_prev->lru_next = entry->lru_next; else cache->lru_head = entry->lru_next;
+	if( entry->lru_next ) entry->lru_next->lru_prev = entry->lru_prev; else cache->lru_tail = entry->lru_prev;
+	entry->lru_prev = 0x0;
+	entry->lru_next = 0x0;
+}
+
+static void http_cache_lru_push( http_client_cache* cache, http_cache_entry* entry )
+{
+	entry->lru_prev = 0x0;
+	entry->lru_next = cache->lru_head;
+	if( cache->lru_head )
+		cache->lru_head->lru_prev = entry;
+	else
+		cache->lru_tail = entry;
+	cache->lru_head = entry;
+}
+
+/**
+ * Drop a reference to entry, freeing it when it was the last one. Expects cache to be locked.
+ */
+static void http_cache_entry_unref( http_client_cache* cache, http_cache_entry* entry )
+{
+	if( --entry->refs > 0 )
+		return;
+	if( entry->mapped )
+		http_disk_cache_unpin( cache->disk, entry->disk_offset );
+	else
+		free( entry->body );
+	free( entry );
+}
+
+/**
+ * Remove entry from cache, it stays alive until all lookups using it are released. Expects cache to be locked.
+ */
+static void http_cache_remove( http_client_cache* cache, http_cache_entry* entry )
+{
+	http_cache_entry** link = &cache->buckets[entry->hash % HTTP_CACHE_BUCKETS];
+	while( *link != entry )
+		link = &(*link)->hash_next;
+	*link = entry->hash_next;
+	http_cache_lru_unlink( cache, entry );
+
+	--cache->stats.entries;
+	cache->stats.bytes -= entry->size;
+	http_cache_entry_unref( cache, entry );
+}
+
+http_client_result http_client_cache_create( http_client_cache_t* cache, const http_client_cache_config* config )
+{
+	http_client_cache* c = (http_client_cache*)malloc( sizeof( http_client_cache ) );
+	if( c == 0x0 )
+		return HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+
+	memset( c, 0x0, sizeof( http_client_cache ) );
+	if( config )
+		c->config = *config;
+	if( c->config.max_bytes == 0 )      c->config.max_bytes = 16 * 1024 * 1024;
+	if( c->config.max_entry_size == 0 ) c->config.max_entry_size = c->config.max_bytes / 8;
+
+	if( c->config.path )
+	{
+		http_client_result res = http_disk_cache_open( &c->disk, c->config.path, c->config.max_bytes );
+		if( res != HTTP_CLIENT_OK )
+		{
+			free( c );
+			return res;
+		}
+	}
+
+	http_client_mutex_init( &c->mutex );
+	*cache = c;
+	return HTTP_CLIENT_OK;
+}
+
+void http_client_cache_destroy( http_client_cache_t cache )
+{
+	// ... the disk cache is kept as is, to be used again on the next start ...
+	while( cache->lru_head )
+		http_cache_remove( cache, cache->lru_head );
+	if( cache->disk )
+		http_disk_cache_close( cache->disk );
+	http_client_mutex_destroy( &cache->mutex );
+	free( cache );
+}
+
+void http_client_set_cache( http_client_t client, http_client_cache_t cache )
+{
+	client->cache = cache;
+}
+
+void http_client_cache_flush( http_client_cache_t cache )
+{
+	http_client_mutex_lock( &cache->mutex );
+	while( cache->lru_head )
+		http_cache_remove( cache, cache->lru_head );
+	if( cache->disk )
+		http_disk_cache_clear( cache->disk );
+	http_client_mutex_unlock( &cache->mutex );
+}
+
+void http_client_cache_get_stats( http_client_cache_t cache, http_client_cache_stats* stats )
+{
+	http_client_mutex_lock( &cache->mutex );
+	*stats = cache->stats;
+	if( cache->disk )
+		http_disk_cache_usage( cache->disk, &stats->entries, &stats->bytes );
+	http_client_mutex_unlock( &cache->mutex );
+}
+
+http_cache_entry* http_client_cache_lookup( http_client_cache* cache, http_client_t client, const char* resource, bool* fresh )
+{
+	char key[HTTP_CACHE_MAX_KEY];
+	unsigned int hash;
+	bool key_ok = http_cache_make_key( client, resource, key, &hash );
+
+	http_client_mutex_lock( &cache->mutex );
+	http_cache_entry* entry = 0x0;
+	if( key_ok )
+		entry = cache->disk ? http_cache_find_disk( cache, key, hash ) : http_cache_find( cache, key, hash );
+	if( entry == 0x0 )
+	{
+		++cache->stats.misses;
+		http_client_mutex_unlock( &cache->mutex );
+		return 0x0;
+	}
+
+	++entry->refs;
+	*fresh = http_client_time_ms() < entry->expires;
+	if( *fresh )
+		++cache->stats.hits;
+	else
+		++cache->stats.stale;
+	if( !entry->mapped )
+	{
+		http_cache_lru_unlink( cache, entry );
+		http_cache_lru_push( cache, entry );
+	}
+	http_client_mutex_unlock( &cache->mutex );
+	return entry;
+}
+
+void http_client_cache_release( http_client_cache* cache, http_cache_entry* entry )
+{
+	http_client_mutex_lock( &cache->mutex );
+	http_cache_entry_unref( cache, entry );
+	http_client_mutex_unlock( &cache->mutex );
+}
+
+void http_client_cache_refresh( http_client_cache* cache, http_cache_entry* entry, unsigned long long lifetime )
+{
+	http_client_mutex_lock( &cache->mutex );
+	entry->expires = http_client_time_ms() + lifetime;
+	if( entry->mapped )
+		http_disk_cache_set_expires( cache->disk, entry->key, entry->hash, entry->disk_offset, http_disk_cache_time() + (long long)lifetime );
+	++cache->stats.revalidated;
+	http_client_mutex_unlock( &cache->mutex );
+}
+
+void http_client_cache_invalidate( http_client_cache* cache, http_client_t client, const char* resource )
+{
+	char key[HTTP_CACHE_MAX_KEY];
+	unsigned int hash;
+	if( !http_cache_make_key( client, resource, key, &hash ) )
+		return;
+
+	http_client_mutex_lock( &cache->mutex );
+	if( cache->disk )
+		http_disk_cache_remove( cache->disk, key, hash );
+	else if( http_cache_entry* entry = http_cache_find( cache, key, hash ) )
+		http_cache_remove( cache, entry );
+	http_client_mutex_unlock( &cache->mutex );
+}
+
+/**
+ * Find the value of directive in a Cache-Control header value, i.e. "max-age" in "private, max-age=60". Returns
+ * false if directive is not present, *arg is set to the numeric argument of the directive or -1 if it has none.
+ */
+static bool http_cache_directive( const char* value, const char* directive, long long* arg )
+{
+	size_t len = strlen( directive );
+	while( *value )
+	{
+		while( *value == ' ' || *value == '\t' || *value == ',' )
+			++value;
+		const char* end = value;
+		while( *end && *end != ',' && *end != '=' && *end != ' ' && *end != '\t' )
+			++end;
+
+		bool match = (size_t)( end - value ) == len && strncasecmp( value, directive, len ) == 0;
+		while( *end == ' ' || *end == '\t' )
+			++end;
+
+		*arg = -1;
+		if( *end == '=' )
+		{
+			++end;
+			while( *end == ' ' || *end == '\t' || *end == '"' )
+				++end;
+			if( *end >= '0' && *end <= '9' )
+				*arg = strtoll( end, 0x0, 10 );
+			while( *end && *end != ',' )
+				++end;
+		}
+
+		if( match )
+			return true;
+		value = end;
+	}
+	return false;
+}
+
+/**
+ * Parse a http-date in the preferred format of rfc 9110, "Sun, 06 Nov 1994 08:49:37 GMT", to seconds since the epoch.
+ */
+static bool http_cache_parse_date( const char* value, long long* t )
+{
+	static const char* months = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+	char wkday[4];
+	char mon[4];
+	int day, year, hour, min, sec;
+	if( sscanf( value, "%3s, %d %3s %d %d:%d:%d GMT", wkday, &day, mon, &year, &hour, &min, &sec ) != 7 )
+		return false;
+
+	const char* m = strstr( months, mon );
+	if( m == 0x0 || strlen( mon ) != 3 || ( m - months ) % 3 != 0 || year < 1970 )
+		return false;
+
+	// ... days since the epoch from the civil date, month counted from march to put the leap day last ...
+	long long month = ( m - months ) / 3 + 1;
+	long long y = year - ( month <= 2 ? 1 : 0 );
+	long long era = y / 400;
+	long long yoe = y - era * 400;
+	long long doy = ( 153 * ( month > 2 ? month - 3 : month + 9 ) + 2 ) / 5 + day - 1;
+	long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	long long days = era * 146097 + doe - 719468;
+
+	*t = days * 86400 + hour * 3600 + min * 60 + sec;
+	return true;
+}
+
+/**
+ * Return true if the response only varies on Accept-Encoding, the body is then stored decoded and the same for
+ * all requests.
+ */
+static bool http_cache_vary_ok( const char* value )
+{
+	while( *value )
+	{
+		while( *value == ' ' || *value == '\t' || *value == ',' )
+			++value;
+		const char* end = value;
+		while( *end && *end != ',' && *end != ' ' && *end != '\t' )
+			++end;
+		if( end != value && !( end - value == 15 && strncasecmp( value, "accept-encoding", 15 ) == 0 ) )
+			return false;
+		value = end;
+	}
+	return true;
+}
+
+bool http_client_cache_policy( http_client_t client, const http_response* response, unsigned long long* lifetime, size_t* max_size )
+{
+	const http_client_header* vary = http_client_get_header( client, HTTP_CLIENT_HEADER_VARY );
+	if( vary && !http_cache_vary_ok( vary->value ) )
+		return false;
+
+	// ... the body is passed on encoded with a coding the client do not decompress ...
+	if( response->content_encoding & ~client->decode_encodings )
+		return false;
+
+	bool no_cache = false;
+	long long fresh_ms = -1;
+
+	const http_client_header* cache_control = http_client_get_header( client, HTTP_CLIENT_HEADER_CACHE_CONTROL );
+	if( cache_control )
+	{
+		long long arg;
+		if( http_cache_directive( cache_control->value, "no-store", &arg ) )
+			return false;
+		no_cache = http_cache_directive( cache_control->value, "no-cache", &arg );
+		if( http_cache_directive( cache_control->value, "max-age", &arg ) )
+			fresh_ms = arg < 0 ? 0 : arg * 1000;
+	}
+	else if( const http_client_header* pragma = http_client_get_header( client, HTTP_CLIENT_HEADER_PRAGMA ) )
+		no_cache = http_client_header_has_token( pragma->value, "no-cache" );
+
+	const http_client_header* expires = http_client_get_header( client, HTTP_CLIENT_HEADER_EXPIRES );
+	if( fresh_ms < 0 && expires )
+	{
+		// ... compared to the date of the server, not our clock. An invalid Expires means already expired ...
+		const http_client_header* date = http_client_get_header( client, HTTP_CLIENT_HEADER_DATE );
+		long long expires_at;
+		long long now;
+		if( date == 0x0 || !http_cache_parse_date( date->value, &now ) )
+			now = (long long)time( 0x0 );
+		fresh_ms = http_cache_parse_date( expires->value, &expires_at ) && expires_at > now ? ( expires_at - now ) * 1000 : 0;
+	}
+
+	if( const http_client_header* age = http_client_get_header( client, HTTP_CLIENT_HEADER_AGE ) )
+		if( fresh_ms > 0 )
+			fresh_ms -= strtoll( age->value, 0x0, 10 ) * 1000;
+
+	if( no_cache || fresh_ms < 0 )
+		fresh_ms = 0;
+
+	// ... without a lifetime the response is only useful if it can be revalidated ...
+	bool has_validator = http_client_get_header( client, HTTP_CLIENT_HEADER_ETAG ) || http_client_get_header( client, HTTP_CLIENT_HEADER_LAST_MODIFIED );
+	if( fresh_ms == 0 && !has_validator )
+		return false;
+
+	*lifetime = (unsigned long long)fresh_ms;
+	*max_size = client->cache->config.max_entry_size;
+	return true;
+}
+
+/**
+ * Headers that describe the connection or message framing and not the response, these are never stored.
+ */
+static bool http_cache_store_header( const http_client_header* header, bool decoded )
+{
+	switch( http_client_classify_header( header->name, header->name_len ) )
+	{
+		case HTTP_CLIENT_HEADER_CONNECTION:
+		case HTTP_CLIENT_HEADER_KEEP_ALIVE:
+		case HTTP_CLIENT_HEADER_TRANSFER_ENCODING:
+			return false;
+		case HTTP_CLIENT_HEADER_CONTENT_ENCODING:
+		case HTTP_CLIENT_HEADER_CONTENT_LENGTH:
+			return !decoded;
+		default:
+			return true;
+	}
+}
+
+void http_client_cache_store( http_client_cache* cache, http_client_t client, const char* resource, unsigned long long lifetime, void* body, size_t body_size, bool decoded )
+{
+	char key[HTTP_CACHE_MAX_KEY];
+	unsigned int hash;
+	if( body_size > cache->config.max_entry_size || !http_cache_make_key( client, resource, key, &hash ) )
+	{
+		free( body );
+		return;
+	}
+
+	size_t key_size = strlen( key ) + 1;
+	size_t headers_size = 0;
+	for( size_t i = 0; i < client->num_headers; ++i )
+		if( http_cache_store_header( &client->headers[i], decoded ) )
+			headers_size += client->headers[i].name_len + client->headers[i].value_len + 2;
+
+	size_t alloc_size = sizeof( http_cache_entry ) + key_size + headers_size;
+	http_cache_entry* entry = (http_cache_entry*)malloc( alloc_size );
+	if( entry == 0x0 )
+	{
+		free( body );
+		return;
+	}
+
+	memset( entry, 0x0, sizeof( http_cache_entry ) );
+	char* key_mem = (char*)( entry + 1 );
+	char* headers = key_mem + key_size;
+	memcpy( key_mem, key, key_size );
+	entry->key = key_mem;
+	entry->hash = hash;
+	entry->refs = 1;
+	entry->headers = headers;
+	entry->headers_size = headers_size;
+	entry->body = body;
+	entry->body_size = body_size;
+	entry->size = alloc_size + body_size;
+
+	for( size_t i = 0; i < client->num_headers; ++i )
+	{
+		const http_client_header* header = &client->headers[i];
+		if( !http_cache_store_header( header, decoded ) )
+			continue;
+
+		memcpy( headers, header->name, header->name_len );
+		headers[header->name_len] = '\0';
+		char* value = headers + header->name_len + 1;
+		memcpy( value, header->value, header->value_len );
+		value[header->value_len] = '\0';
+		headers = value + header->value_len + 1;
+		++entry->num_headers;
+	}
+	http_cache_index_headers( entry );
+
+	http_client_mutex_lock( &cache->mutex );
+
+	if( cache->disk )
+	{
+		long long expires = http_disk_cache_time() + (long long)lifetime;
+		if( http_disk_cache_store( cache->disk, key, hash, entry->headers, headers_size, entry->num_headers, body, body_size, expires, &cache->stats.evicted ) )
+			++cache->stats.stores;
+		http_client_mutex_unlock( &cache->mutex );
+		free( body );
+		free( entry );
+		return;
+	}
+
+	entry->expires = http_client_time_ms() + lifetime;
+	if( http_cache_entry* old = http_cache_find( cache, key, hash ) )
+		http_cache_remove( cache, old );
+
+	while( cache->lru_tail && cache->stats.bytes + entry->size > cache->config.max_bytes )
+	{
+		http_cache_remove( cache, cache->lru_tail );
+		++cache->stats.evicted;
+	}
+
+	entry->hash_next = cache->buckets[hash % HTTP_CACHE_BUCKETS];
+	cache->buckets[hash % HTTP_CACHE_BUCKETS] = entry;
+	http_cache_lru_push( cache, entry );
+	++cache->stats.entries;
+	++cache->stats.stores;
+	cache->stats.bytes += entry->size;
+
+	http_client_mutex_unlock( &cache->mutex );
+}
+
+void http_client_cache_restore_headers( http_client_t client, const http_cache_entry* entry )
+{
+	client->num_headers = 0;
+	memset( client->known_headers, 0x0, sizeof( client->known_headers ) );
+
+	// ... headers that do not fit in the receive buffer are dropped, as when they are received ...
+	size_t size = entry->headers_size < client->recv_buffer_size ? entry->headers_size : client->recv_buffer_size;
+	memcpy( client->recv_buffer, entry->headers, size );
+
+	const char* end = client->recv_buffer + size;
+	const char* name = client->recv_buffer;
+	for( size_t i = 0; i < entry->num_headers && client->num_headers < HTTP_CLIENT_MAX_HEADERS; ++i )
+	{
+		size_t name_len = strnlen( name, (size_t)( end - name ) );
+		const char* value = name + name_len + 1;
+		if( value >= end )
+			break;
+		size_t value_len = strnlen( value, (size_t)( end - value ) );
+		if( value + value_len >= end )
+			break;
+
+		http_client_header_id id = http_client_classify_header( name, name_len );
+		if( id != HTTP_CLIENT_HEADER_UNKNOWN && client->known_headers[id] == 0 )
+			client->known_headers[id] = (unsigned char)( client->num_headers + 1 );
+
+		http_client_header* header = &client->headers[client->num_headers++];
+		header->name      = name;
+		header->name_len  = name_len;
+		header->value     = value;
+		header->value_len = value_len;
+		name = value + value_len + 1;
+	}
+}
@@ -0,0 +1,377 @@
+/*
+    Simple http-client written to be an drop-in code, focus is to be small
+    and easy to use but maybe not efficient.
+
+    version 1.0, June, 2014
+
+	Copyright (C) 2014- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+#include "http_client_decode.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined( HTTP_CLIENT_WITH_ZLIB )
+#  include <zlib.h>
+#endif
+#if defined( HTTP_CLIENT_WITH_BROTLI )
+#  include <brotli/decode.h>
+#endif
+#if defined( HTTP_CLIENT_WITH_ZSTD )
+#  include <zstd.h>
+#endif
+
+#if defined( _MSC_VER )
+#  define strncasecmp _strnicmp
+#else
+#  include <strings.h>
+#endif
+
+struct http_decoder
+{
+	unsigned int encoding; ///< HTTP_CLIENT_ENCODING_* currently decoded.
+	bool done;
+
+#if defined( HTTP_CLIENT_WITH_ZLIB )
+	z_stream zlib;
+	bool zlib_init;
+	bool raw_deflate;      ///< deflate-body is sent without zlib-wrapper, as done by some servers.
+#endif
+#if defined( HTTP_CLIENT_WITH_BROTLI )
+	BrotliDecoderState* brotli;
+#endif
+#if defined( HTTP_CLIENT_WITH_ZSTD )
+	ZSTD_DStream* zstd;
+#endif
+};
+
+struct http_decoder_coding
+{
+	const char* name;
+	unsigned int encoding;
+};
+
+static const http_decoder_coding http_decoder_codings[] = {
+	{ "gzip",    HTTP_CLIENT_ENCODING_GZIP },
+	{ "x-gzip",  HTTP_CLIENT_ENCODING_GZIP },
+	{ "deflate", HTTP_CLIENT_ENCODING_DEFLATE },
+	{ "br",      HTTP_CLIENT_ENCODING_BROTLI },
+	{ "zstd",    HTTP_CLIENT_ENCODING_ZSTD },
+};
+
+unsigned int http_client_decoder_supported()
+{
+	unsigned int encodings = 0;
+#if defined( HTTP_CLIENT_WITH_ZLIB )
+	encodings |= HTTP_CLIENT_ENCODING_GZIP | HTTP_CLIENT_ENCODING_DEFLATE;
+#endif
+#if defined( HTTP_CLIENT_WITH_BROTLI )
+	encodings |= HTTP_CLIENT_ENCODING_BROTLI;
+#endif
+#if defined( HTTP_CLIENT_WITH_ZSTD )
+	encodings |= HTTP_CLIENT_ENCODING_ZSTD;
+#endif
+	return encodings;
+}
+
+unsigned int http_client_decoder_parse_encoding( const char* value )
+{
+	unsigned int encoding = 0;
+	while( *value )
+	{
+		while( *value == ' ' || *value == '\t' || *value == ',' )
+			++value;
+		const char* tokend = value;
+		while( *tokend && *tokend != ',' && *tokend != ' ' && *tokend != '\t' )
+			++tokend;
+		size_t toklen = (size_t)( tokend - value );
+		if( toklen == 0 )
+			break;
+
+		unsigned int coding = 0;
+		for( size_t i = 0; i < sizeof( http_decoder_codings ) / sizeof( http_decoder_codings[0] ); ++i )
+			if( strlen( http_decoder_codings[i].name ) == toklen && strncasecmp( value, http_decoder_codings[i].name, toklen ) == 0 )
+				coding = http_decoder_codings[i].encoding;
+
+		// ... identity is a no-op, anything unknown or stacked codings are passed through undecoded ...
+		bool identity = toklen == 8 && strncasecmp( value, "identity", 8 ) == 0;
+		if( !identity )
+		{
+			if( coding == 0 || encoding != 0 )
+				return 0;
+			encoding = coding;
+		}
+		value = tokend;
+	}
+	return encoding;
+}
+
+int http_client_decoder_accept_encoding( char* buffer, size_t buffer_size, unsigned int encodings )
+{
+	static const char* names[] = { "gzip", "deflate", "br", "zstd" };
+
+	const char* list[4];
+	int count = 0;
+	for( int i = 0; i < 4; ++i )
+		if( encodings & ( 1u << i ) )
+			list[count++] = names[i];
+
+	switch( count )
+	{
+		case 0:  return snprintf( buffer, buffer_size, "%s", "" );
+		case 1:  return snprintf( buffer, buffer_size, "Accept-Encoding: %s\r\n", list[0] );
+		case 2:  return snprintf( buffer, buffer_size, "Accept-Encoding: %s, %s\r\n", list[0], list[1] );
+		case 3:  return snprintf( buffer, buffer_size, "Accept-Encoding: %s, %s, %s\r\n", list[0], list[1], list[2] );
+		default: return snprintf( buffer, buffer_size, "Accept-Encoding: %s, %s, %s, %s\r\n", list[0], list[1], list[2], list[3] );
+	}
+}
+
+#if defined( HTTP_CLIENT_WITH_ZLIB )
+static bool http_decoder_zlib_init( http_decoder* decoder )
+{
+	// ... 16 + MAX_WBITS only accepts a gzip-wrapper, a negative window a raw deflate stream ...
+	int window_bits = MAX_WBITS;
+	if( decoder->encoding == HTTP_CLIENT_ENCODING_GZIP )
+		window_bits = 16 + MAX_WBITS;
+	else if( decoder->raw_deflate )
+		window_bits = -MAX_WBITS;
+
+	if( decoder->zlib_init )
+		return inflateReset2( &decoder->zlib, window_bits ) == Z_OK;
+
+	memset( &decoder->zlib, 0x0, sizeof( decoder->zlib ) );
+	decoder->zlib_init = inflateInit2( &decoder->zlib, window_bits ) == Z_OK;
+	return decoder->zlib_init;
+}
+
+static http_client_result http_decoder_zlib_run( http_decoder* decoder, const void** in, size_t* in_size, void* out, size_t out_size, size_t* produced )
+{
+	z_stream* z = &decoder->zlib;
+	uInt avail_in  = *in_size  > 0x7fffffff ? 0x7fffffff : (uInt)*in_size;
+	uInt avail_out = out_size > 0x7fffffff ? 0x7fffffff : (uInt)out_size;
+	z->next_in   = (Bytef*)*in;
+	z->avail_in  = avail_in;
+	z->next_out  = (Bytef*)out;
+	z->avail_out = avail_out;
+
+	uLong total_in = z->total_in;
+	int res = inflate( z, Z_NO_FLUSH );
+
+	if( res == Z_DATA_ERROR && decoder->encoding == HTTP_CLIENT_ENCODING_DEFLATE && !decoder->raw_deflate && total_in == 0 && z->total_out == 0 )
+	{
+		// ... no zlib-header, retry the same input as a raw deflate stream ...
+		decoder->raw_deflate = true;
+		if( !http_decoder_zlib_init( decoder ) )
+			return HTTP_CLIENT_DECODE_ERROR;
+		return http_decoder_zlib_run( decoder, in, in_size, out, out_size, produced );
+	}
+
+	size_t consumed = avail_in - z->avail_in;
+	*produced = avail_out - z->avail_out;
+	*in = (const char*)*in + consumed;
+	*in_size -= consumed;
+
+	switch( res )
+	{
+		case Z_OK:
+		case Z_BUF_ERROR: // ... no progress possible without more input or output, not an error here ...
+			return HTTP_CLIENT_OK;
+		case Z_STREAM_END:
+			// ... for gzip only the end of a member, http_decoder_next_member() restarts if another one follows ...
+			decoder->done = true;
+			return HTTP_CLIENT_OK;
+		default:
+			return HTTP_CLIENT_DECODE_ERROR;
+	}
+}
+#endif
+
+#if defined( HTTP_CLIENT_WITH_BROTLI )
+static http_client_result http_decoder_brotli_run( http_decoder* decoder, const void** in, size_t* in_size, void* out, size_t out_size, size_t* produced )
+{
+	const uint8_t* next_in = (const uint8_t*)*in;
+	uint8_t* next_out = (uint8_t*)out;
+	size_t avail_out = out_size;
+	BrotliDecoderResult res = BrotliDecoderDecompressStream( decoder->brotli, in_size, &next_in, &avail_out, &next_out, 0x0 );
+	*in = next_in;
+	*produced = out_size - avail_out;
+	if( res == BROTLI_DECODER_RESULT_ERROR )
+		return HTTP_CLIENT_DECODE_ERROR;
+	if( res == BROTLI_DECODER_RESULT_SUCCESS )
+		decoder->done = true;
+	return HTTP_CLIENT_OK;
+}
+#endif
+
+#if defined( HTTP_CLIENT_WITH_ZSTD )
+static http_client_result http_decoder_zstd_run( http_decoder* decoder, const void** in, size_t* in_size, void* out, size_t out_size, size_t* produced )
+{
+	ZSTD_inBuffer  input  = { *in, *in_size, 0 };
+	ZSTD_outBuffer output = { out, out_size, 0 };
+	size_t res = ZSTD_decompressStream( decoder->zstd, &output, &input );
+	*in = (const char*)*in + input.pos;
+	*in_size -= input.pos;
+	*produced = output.pos;
+	if( ZSTD_isError( res ) )
+		return HTTP_CLIENT_DECODE_ERROR;
+	// ... 0 is returned when a frame is complete, http_decoder_next_member() continues if more frames follow ...
+	decoder->done = res == 0;
+	return HTTP_CLIENT_OK;
+}
+#endif
+
+http_client_result http_client_decoder_begin( http_decoder** decoder, unsigned int encoding )
+{
+	if( ( http_client_decoder_supported() & encoding ) == 0 )
+		return HTTP_CLIENT_NOT_SUPPORTED;
+
+	http_decoder* d = *decoder;
+	if( d == 0x0 )
+	{
+		d = (http_decoder*)malloc( sizeof( http_decoder ) );
+		if( d == 0x0 )
+			return HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+		memset( d, 0x0, sizeof( http_decoder ) );
+		*decoder = d;
+	}
+
+	d->encoding = encoding;
+	d->done = false;
+
+	switch( encoding )
+	{
+#if defined( HTTP_CLIENT_WITH_ZLIB )
+		case HTTP_CLIENT_ENCODING_GZIP:
+		case HTTP_CLIENT_ENCODING_DEFLATE:
+			d->raw_deflate = false;
+			return http_decoder_zlib_init( d ) ? HTTP_CLIENT_OK : HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+#endif
+#if defined( HTTP_CLIENT_WITH_BROTLI )
+		case HTTP_CLIENT_ENCODING_BROTLI:
+			// ... brotli has no reset, state is recreated for each body ...
+			if( d->brotli )
+				BrotliDecoderDestroyInstance( d->brotli );
+			d->brotli = BrotliDecoderCreateInstance( 0x0, 0x0, 0x0 );
+			return d->brotli ? HTTP_CLIENT_OK : HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+#endif
+#if defined( HTTP_CLIENT_WITH_ZSTD )
+		case HTTP_CLIENT_ENCODING_ZSTD:
+			if( d->zstd == 0x0 )
+				d->zstd = ZSTD_createDStream();
+			if( d->zstd == 0x0 )
+				return HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+			return ZSTD_isError( ZSTD_DCtx_reset( d->zstd, ZSTD_reset_session_only ) ) ? HTTP_CLIENT_INTERNAL_ERROR : HTTP_CLIENT_OK;
+#endif
+		default:
+			return HTTP_CLIENT_NOT_SUPPORTED;
+	}
+}
+
+/**
+ * Called with input left after the end of a stream has been decoded. A gzip-body can be several concatenated members
+ * and a zstd-body several frames, in that case the decoder is prepared for the next one and true is returned. The
+ * end of a member/frame might just as well have ended the chunk of body that was received, so this is checked on
+ * the next input and not when the end was found.
+ */
+static bool http_decoder_next_member( http_decoder* decoder, const void* in, size_t in_size )
+{
+	const unsigned char* bytes = (const unsigned char*)in;
+	switch( decoder->encoding )
+	{
+#if defined( HTTP_CLIENT_WITH_ZLIB )
+		case HTTP_CLIENT_ENCODING_GZIP:
+			// ... only restart on something that can start a gzip-header, anything else is trailing garbage ...
+			if( bytes[0] != 0x1f || ( in_size > 1 && bytes[1] != 0x8b ) )
+				return false;
+			if( !http_decoder_zlib_init( decoder ) )
+				return false;
+			decoder->done = false;
+			return true;
+#endif
+#if defined( HTTP_CLIENT_WITH_ZSTD )
+		case HTTP_CLIENT_ENCODING_ZSTD:
+			// ... the dstream starts on a new frame by itself after the end of the last one ...
+			decoder->done = false;
+			return true;
+#endif
+		default:
+			(void)bytes; (void)in_size;
+			return false;
+	}
+}
+
+http_client_result http_client_decoder_run( http_decoder* decoder, const void** in, size_t* in_size, void* out, size_t out_size, size_t* produced )
+{
+	*produced = 0;
+	if( decoder->done && ( *in_size == 0 || !http_decoder_next_member( decoder, *in, *in_size ) ) )
+	{
+		// ... ignore anything after the end of the stream ...
+		*in = (const char*)*in + *in_size;
+		*in_size = 0;
+		return HTTP_CLIENT_OK;
+	}
+
+	switch( decoder->encoding )
+	{
+#if defined( HTTP_CLIENT_WITH_ZLIB )
+		case HTTP_CLIENT_ENCODING_GZIP:
+		case HTTP_CLIENT_ENCODING_DEFLATE:
+			return http_decoder_zlib_run( decoder, in, in_size, out, out_size, produced );
+#endif
+#if defined( HTTP_CLIENT_WITH_BROTLI )
+		case HTTP_CLIENT_ENCODING_BROTLI:
+			return http_decoder_brotli_run( decoder, in, in_size, out, out_size, produced );
+#endif
+#if defined( HTTP_CLIENT_WITH_ZSTD )
+		case HTTP_CLIENT_ENCODING_ZSTD:
+			return http_decoder_zstd_run( decoder, in, in_size, out, out_size, produced );
+#endif
+		default:
+			(void)in; (void)in_size; (void)out; (void)out_size;
+			return HTTP_CLIENT_INTERNAL_ERROR;
+	}
+}
+
+bool http_client_decoder_done( const http_decoder* decoder )
+{
+	return decoder->done;
+}
+
+void http_client_decoder_destroy( http_decoder* decoder )
+{
+	if( decoder == 0x0 )
+		return;
+#if defined( HTTP_CLIENT_WITH_ZLIB )
+	if( decoder->zlib_init )
+		inflateEnd( &decoder->zlib );
+#endif
+#if defined( HTTP_CLIENT_WITH_BROTLI )
+	if( decoder->brotli )
+		BrotliDecoderDestroyInstance( decoder->brotli );
+#endif
+#if defined( HTTP_CLIENT_WITH_ZSTD )
+	if( decoder->zstd )
+		ZSTD_freeDStream( decoder->zstd );
+#endif
+	free( decoder );
+}
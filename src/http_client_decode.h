@@ -0,0 +1,81 @@
+/*
+    Simple http-client written to be an drop-in code, focus is to be small
+    and easy to use but maybe not efficient.
+
+    version 1.0, June, 2014
+
+	Copyright (C) 2014- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+#ifndef HTTP_CLIENT_DECODE_H_INCLUDED
+#define HTTP_CLIENT_DECODE_H_INCLUDED
+
+/**
+ * Incremental decompression of content-coded response bodies. Codings are only available if the library is built
+ * with them, gzip and deflate with HTTP_CLIENT_WITH_ZLIB, br with HTTP_CLIENT_WITH_BROTLI and zstd with
+ * HTTP_CLIENT_WITH_ZSTD. Not part of the public api.
+ */
+
+#include <http_client/http_client.h>
+
+struct http_decoder;
+
+/**
+ * Return the HTTP_CLIENT_ENCODING_*-flags of all codings the library is built with.
+ */
+unsigned int http_client_decoder_supported();
+
+/**
+ * Parse the value of a Content-Encoding header, returns the HTTP_CLIENT_ENCODING_*-flag of the coding or 0 if the
+ * body is not encoded, encoded with an unknown coding or with more than one coding.
+ */
+unsigned int http_client_decoder_parse_encoding( const char* value );
+
+/**
+ * Format an Accept-Encoding header, including CRLF, listing encodings to buffer. Return value as snprintf().
+ */
+int http_client_decoder_accept_encoding( char* buffer, size_t buffer_size, unsigned int encodings );
+
+/**
+ * Prepare *decoder to decode a new body encoded with encoding, *decoder is created if NULL and reused otherwise.
+ *
+ * @return HTTP_CLIENT_OK on success, HTTP_CLIENT_NOT_SUPPORTED if the library is not built with encoding.
+ */
+http_client_result http_client_decoder_begin( http_decoder** decoder, unsigned int encoding );
+
+/**
+ * Decode as much as possible of *in to out. *in and *in_size are advanced past the consumed input and *produced is set
+ * to the number of bytes written to out. If all of out was filled the decoder might have more output buffered and
+ * should be called again, even without more input.
+ *
+ * @return HTTP_CLIENT_OK on success, HTTP_CLIENT_DECODE_ERROR if the input is not valid for the coding.
+ */
+http_client_result http_client_decoder_run( http_decoder* decoder, const void** in, size_t* in_size, void* out, size_t out_size, size_t* produced );
+
+/**
+ * Return true if the end of the encoded stream has been decoded. For gzip and zstd this is the end of the last
+ * member/frame decoded so far, further input starting a new one continues the stream.
+ */
+bool http_client_decoder_done( const http_decoder* decoder );
+
+void http_client_decoder_destroy( http_decoder* decoder );
+
+#endif // HTTP_CLIENT_DECODE_H_INCLUDED
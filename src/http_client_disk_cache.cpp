@@ -0,0 +1,528 @@
+/*
+    Simple http-client written to be an drop-in code, focus is to be small
+    and easy to use but maybe not efficient.
+
+    version 1.0, June, 2014
+
+	Copyright (C) 2014- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+#include "http_client_disk_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined( _MSC_VER )
+
+http_client_result http_disk_cache_open( http_disk_cache** disk, const char*, size_t )
+{
+	*disk = 0x0;
+	return HTTP_CLIENT_NOT_SUPPORTED;
+}
+
+void http_disk_cache_close( http_disk_cache* ) {}
+long long http_disk_cache_time() { return (long long)time( 0x0 ) * 1000; }
+bool http_disk_cache_find( http_disk_cache*, const char*, unsigned int, http_disk_view* ) { return false; }
+void http_disk_cache_unpin( http_disk_cache*, unsigned long long ) {}
+bool http_disk_cache_store( http_disk_cache*, const char*, unsigned int, const char*, size_t, size_t, const void*, size_t, long long, unsigned long long* ) { return false; }
+void http_disk_cache_set_expires( http_disk_cache*, const char*, unsigned int, unsigned long long, long long ) {}
+void http_disk_cache_remove( http_disk_cache*, const char*, unsigned int ) {}
+void http_disk_cache_clear( http_disk_cache* ) {}
+void http_disk_cache_usage( http_disk_cache*, unsigned int* entries, size_t* bytes ) { *entries = 0; *bytes = 0; }
+
+#else
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define HTTP_DISK_INDEX_MAGIC  0x58494348u // "HCIX"
+#define HTTP_DISK_RECORD_MAGIC 0x52434348u // "HCCR"
+#define HTTP_DISK_VERSION      1
+#define HTTP_DISK_MAX_PINS     64
+
+struct http_disk_index_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t data_size;  ///< size of the data file.
+	uint64_t num_slots;
+	uint64_t head;       ///< offset the next record is written at.
+	uint64_t tail;       ///< offset of the oldest record, first to be evicted.
+	uint64_t data_end;   ///< end of the last record written before head wrapped to 0, only valid if wrapped.
+	uint32_t wrapped;    ///< head has wrapped around and is behind tail, records are [tail, data_end) and [0, head).
+	uint32_t entries;    ///< live records, each referenced by a slot.
+	uint64_t bytes;      ///< size of all live records.
+};
+
+struct http_disk_slot
+{
+	uint32_t hash;
+	uint32_t used;
+	uint64_t offset;
+	int64_t  expires;
+};
+
+/**
+ * Header of each record in the data file, followed by key, headers and body and padded to 8 bytes. Records that are
+ * replaced or removed stay in the ring as dead records until evicted.
+ */
+struct http_disk_record
+{
+	uint32_t magic;
+	uint32_t hash;
+	uint64_t size;       ///< size of the whole record including this header and padding.
+	uint64_t key_size;   ///< including '\0'.
+	uint64_t headers_size;
+	uint64_t num_headers;
+	uint64_t body_size;
+};
+
+struct http_disk_cache
+{
+	int index_fd;
+	int data_fd;
+	http_disk_index_header* index;
+	http_disk_slot* slots;
+	size_t index_size;
+	char* data;
+	size_t data_size;
+
+	uint64_t pins[HTTP_DISK_MAX_PINS]; ///< offsets of records currently read, these are never evicted.
+	unsigned int num_pins;
+};
+
+long long http_disk_cache_time()
+{
+	timeval tv;
+	gettimeofday( &tv, 0x0 );
+	return (long long)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+static http_disk_record* http_disk_record_at( http_disk_cache* disk, uint64_t offset )
+{
+	return (http_disk_record*)( disk->data + offset );
+}
+
+static const char* http_disk_record_key( const http_disk_record* record )
+{
+	return (const char*)( record + 1 );
+}
+
+static bool http_disk_pinned( http_disk_cache* disk, uint64_t offset )
+{
+	for( unsigned int i = 0; i < disk->num_pins; ++i )
+		if( disk->pins[i] == offset )
+			return true;
+	return false;
+}
+
+/**
+ * Check that the record at offset is complete and within the data file, to not trust a damaged file.
+ */
+static bool http_disk_record_valid( http_disk_cache* disk, uint64_t offset )
+{
+	uint64_t data_size = disk->index->data_size;
+	if( offset % 8 != 0 || offset > data_size - sizeof( http_disk_record ) )
+		return false;
+
+	const http_disk_record* record = http_disk_record_at( disk, offset );
+	if( record->magic != HTTP_DISK_RECORD_MAGIC || record->size > data_size - offset || record->key_size == 0 )
+		return false;
+	uint64_t payload = record->size - sizeof( http_disk_record );
+	if( record->size < sizeof( http_disk_record ) || record->key_size > payload || record->headers_size > payload || record->body_size > payload )
+		return false;
+	return record->key_size + record->headers_size + record->body_size <= payload && http_disk_record_key( record )[record->key_size - 1] == '\0';
+}
+
+static void http_disk_reset( http_disk_cache* disk, uint64_t data_size, uint64_t num_slots )
+{
+	memset( disk->index, 0x0, disk->index_size );
+	disk->index->magic     = HTTP_DISK_INDEX_MAGIC;
+	disk->index->version   = HTTP_DISK_VERSION;
+	disk->index->data_size = data_size;
+	disk->index->num_slots = num_slots;
+}
+
+static http_disk_slot* http_disk_find_slot( http_disk_cache* disk, const char* key, unsigned int hash )
+{
+	uint64_t mask = disk->index->num_slots - 1;
+	for( uint64_t i = hash & mask; disk->slots[i].used; i = ( i + 1 ) & mask )
+	{
+		http_disk_slot* slot = &disk->slots[i];
+		if( slot->hash == hash && http_disk_record_valid( disk, slot->offset ) && strcmp( http_disk_record_key( http_disk_record_at( disk, slot->offset ) ), key ) == 0 )
+			return slot;
+	}
+	return 0x0;
+}
+
+/**
+ * Remove slot from the hash table, moving back later slots to not leave a hole in their probe sequence.
+ */
+static void http_disk_remove_slot( http_disk_cache* disk, http_disk_slot* slot )
+{
+	http_disk_index_header* h = disk->index;
+	--h->entries;
+	h->bytes -= http_disk_record_at( disk, slot->offset )->size;
+
+	uint64_t mask = h->num_slots - 1;
+	uint64_t i = (uint64_t)( slot - disk->slots );
+	disk->slots[i].used = 0;
+	for( uint64_t j = ( i + 1 ) & mask; disk->slots[j].used; j = ( j + 1 ) & mask )
+	{
+		uint64_t ideal = disk->slots[j].hash & mask;
+		bool movable = i <= j ? ( ideal <= i || ideal > j ) : ( ideal <= i && ideal > j );
+		if( movable )
+		{
+			disk->slots[i] = disk->slots[j];
+			disk->slots[j].used = 0;
+			i = j;
+		}
+	}
+}
+
+/**
+ * Evict the oldest record in the ring, returns false if the ring is empty or the record is pinned. A damaged ring is
+ * reset, but not while records are pinned since that would let new records overwrite memory still being read.
+ */
+static bool http_disk_evict_tail( http_disk_cache* disk, unsigned long long* evicted )
+{
+	http_disk_index_header* h = disk->index;
+	if( !h->wrapped && h->tail == h->head )
+		return false;
+	if( http_disk_pinned( disk, h->tail ) )
+		return false;
+
+	if( !http_disk_record_valid( disk, h->tail ) )
+	{
+		// ... damaged ring, start over when nothing points into it anymore ...
+		if( disk->num_pins > 0 )
+			return false;
+		http_disk_reset( disk, h->data_size, h->num_slots );
+		return true;
+	}
+
+	http_disk_record* record = http_disk_record_at( disk, h->tail );
+	http_disk_slot* slot = http_disk_find_slot( disk, http_disk_record_key( record ), record->hash );
+	if( slot != 0x0 && slot->offset == h->tail )
+	{
+		http_disk_remove_slot( disk, slot );
+		++*evicted;
+	}
+
+	h->tail += record->size;
+	if( h->wrapped && h->tail >= h->data_end )
+	{
+		h->tail = 0;
+		h->wrapped = 0;
+	}
+	return true;
+}
+
+/**
+ * Make room for size bytes at the head of the ring, evicting the oldest records as needed.
+ */
+static bool http_disk_reserve( http_disk_cache* disk, uint64_t size, uint64_t* offset, unsigned long long* evicted )
+{
+	http_disk_index_header* h = disk->index;
+	if( size > h->data_size )
+		return false;
+
+	while( true )
+	{
+		if( !h->wrapped )
+		{
+			if( h->data_size - h->head >= size )
+				break;
+
+			// ... does not fit before the end of the file, continue from the start ...
+			if( h->tail == h->head )
+				h->tail = 0;
+			else
+			{
+				h->data_end = h->head;
+				h->wrapped = 1;
+			}
+			h->head = 0;
+			continue;
+		}
+
+		if( h->tail - h->head >= size )
+			break;
+		if( !http_disk_evict_tail( disk, evicted ) )
+			return false;
+	}
+
+	*offset = h->head;
+	h->head += size;
+	return true;
+}
+
+static bool http_disk_append( http_disk_cache* disk,
+							  const char* key,
+							  unsigned int hash,
+							  const char* headers,
+							  size_t headers_size,
+							  size_t num_headers,
+							  const void* body,
+							  size_t body_size,
+							  long long expires,
+							  unsigned long long* evicted )
+{
+	http_disk_index_header* h = disk->index;
+	size_t key_size = strlen( key ) + 1;
+	uint64_t size = ( sizeof( http_disk_record ) + key_size + headers_size + body_size + 7 ) & ~(uint64_t)7;
+
+	// ... keep the hash table at most 3/4 full, a record replacing the one of key does not add to it. The old record
+	//     is only replaced once the new one is written so that a failure leaves it in place ...
+	while( h->entries - ( http_disk_find_slot( disk, key, hash ) ? 1 : 0 ) >= h->num_slots / 4 * 3 )
+		if( !http_disk_evict_tail( disk, evicted ) )
+			return false;
+
+	uint64_t offset;
+	if( !http_disk_reserve( disk, size, &offset, evicted ) )
+		return false;
+
+	http_disk_record* record = http_disk_record_at( disk, offset );
+	record->magic        = HTTP_DISK_RECORD_MAGIC;
+	record->hash         = hash;
+	record->size         = size;
+	record->key_size     = key_size;
+	record->headers_size = headers_size;
+	record->num_headers  = num_headers;
+	record->body_size    = body_size;
+	char* dst = (char*)( record + 1 );
+	memcpy( dst, key, key_size );
+	memcpy( dst + key_size, headers, headers_size );
+	memcpy( dst + key_size + headers_size, body, body_size );
+
+	if( http_disk_slot* old = http_disk_find_slot( disk, key, hash ) )
+		http_disk_remove_slot( disk, old );
+
+	uint64_t mask = h->num_slots - 1;
+	uint64_t i = hash & mask;
+	while( disk->slots[i].used )
+		i = ( i + 1 ) & mask;
+	disk->slots[i].hash    = hash;
+	disk->slots[i].used    = 1;
+	disk->slots[i].offset  = offset;
+	disk->slots[i].expires = expires;
+	++h->entries;
+	h->bytes += size;
+	return true;
+}
+
+/**
+ * Map fd of size bytes, extending or truncating the file if needed. *resized is set if the file had another size.
+ */
+static void* http_disk_map( int fd, size_t size, bool* resized )
+{
+	struct stat st;
+	if( fstat( fd, &st ) != 0 )
+		return 0x0;
+	*resized = (size_t)st.st_size != size;
+	if( *resized && ftruncate( fd, (off_t)size ) != 0 )
+		return 0x0;
+	void* mem = mmap( 0x0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+	return mem == MAP_FAILED ? 0x0 : mem;
+}
+
+http_client_result http_disk_cache_open( http_disk_cache** disk, const char* path, size_t data_size )
+{
+	*disk = 0x0;
+
+	// ... about one slot per 4kb of data, rounded up to a power of two ...
+	uint64_t num_slots = 1024;
+	while( num_slots < data_size / 4096 && num_slots < ( 1u << 24 ) )
+		num_slots *= 2;
+	data_size &= ~(size_t)7;
+	if( data_size < 4096 )
+		return HTTP_CLIENT_INTERNAL_ERROR;
+
+	http_disk_cache* d = (http_disk_cache*)malloc( sizeof( http_disk_cache ) );
+	if( d == 0x0 )
+		return HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+	memset( d, 0x0, sizeof( http_disk_cache ) );
+	d->index_size = sizeof( http_disk_index_header ) + (size_t)num_slots * sizeof( http_disk_slot );
+	d->data_size = data_size;
+	d->index_fd = -1;
+	d->data_fd = -1;
+
+	char file[1024];
+	bool ok = snprintf( file, sizeof( file ), "%s.idx", path ) < (int)sizeof( file );
+	if( ok )
+		d->index_fd = open( file, O_RDWR | O_CREAT, 0644 );
+	ok = ok && snprintf( file, sizeof( file ), "%s.dat", path ) < (int)sizeof( file );
+	if( ok )
+		d->data_fd = open( file, O_RDWR | O_CREAT, 0644 );
+
+	// ... the files are written without any coordination, only one process may use them at a time ...
+	ok = ok && d->index_fd >= 0 && d->data_fd >= 0 && flock( d->index_fd, LOCK_EX | LOCK_NB ) == 0;
+
+	bool index_resized = false;
+	bool data_resized = false;
+	if( ok )
+	{
+		d->index = (http_disk_index_header*)http_disk_map( d->index_fd, d->index_size, &index_resized );
+		d->data  = (char*)http_disk_map( d->data_fd, data_size, &data_resized );
+		ok = d->index != 0x0 && d->data != 0x0;
+	}
+	if( !ok )
+	{
+		http_disk_cache_close( d );
+		return HTTP_CLIENT_FILE_ERROR;
+	}
+
+	d->slots = (http_disk_slot*)( d->index + 1 );
+	http_disk_index_header* h = d->index;
+	bool valid = !index_resized && !data_resized
+			  && h->magic == HTTP_DISK_INDEX_MAGIC && h->version == HTTP_DISK_VERSION
+			  && h->data_size == data_size && h->num_slots == num_slots
+			  && h->head <= data_size && h->tail <= data_size && ( !h->wrapped || ( h->head <= h->tail && h->data_end <= data_size ) );
+	if( !valid )
+		http_disk_reset( d, data_size, num_slots );
+
+	*disk = d;
+	return HTTP_CLIENT_OK;
+}
+
+void http_disk_cache_close( http_disk_cache* disk )
+{
+	if( disk->index )
+		munmap( disk->index, disk->index_size );
+	if( disk->data )
+		munmap( disk->data, disk->data_size );
+	if( disk->index_fd >= 0 )
+		close( disk->index_fd );
+	if( disk->data_fd >= 0 )
+		close( disk->data_fd );
+	free( disk );
+}
+
+bool http_disk_cache_find( http_disk_cache* disk, const char* key, unsigned int hash, http_disk_view* view )
+{
+	http_disk_slot* slot = http_disk_find_slot( disk, key, hash );
+	if( slot == 0x0 || disk->num_pins == HTTP_DISK_MAX_PINS )
+		return false;
+
+	// ... a record that is about to be evicted is moved to the head of the ring, keeping used records around ...
+	http_disk_index_header* h = disk->index;
+	uint64_t from_tail = slot->offset >= h->tail ? slot->offset - h->tail : h->data_end - h->tail + slot->offset;
+	if( from_tail < h->data_size / 4 && !http_disk_pinned( disk, slot->offset ) )
+	{
+		const http_disk_record* record = http_disk_record_at( disk, slot->offset );
+		void* copy = malloc( (size_t)record->size );
+		if( copy )
+		{
+			// ... pinned while moving so that making room for the copy can't evict it, if there is no room the record
+			//     is served from where it is ...
+			uint64_t offset = slot->offset;
+			disk->pins[disk->num_pins++] = offset;
+			memcpy( copy, record, (size_t)record->size );
+			const http_disk_record* r = (const http_disk_record*)copy;
+			const char* payload = (const char*)( r + 1 );
+			unsigned long long evicted = 0;
+			http_disk_append( disk, payload, hash, payload + r->key_size, (size_t)r->headers_size, (size_t)r->num_headers, payload + r->key_size + r->headers_size, (size_t)r->body_size, slot->expires, &evicted );
+			free( copy );
+			http_disk_cache_unpin( disk, offset );
+			slot = http_disk_find_slot( disk, key, hash );
+			if( slot == 0x0 )
+				return false;
+		}
+	}
+
+	const http_disk_record* record = http_disk_record_at( disk, slot->offset );
+	const char* payload = (const char*)( record + 1 );
+	view->offset       = slot->offset;
+	view->key          = payload;
+	view->headers      = payload + record->key_size;
+	view->headers_size = (size_t)record->headers_size;
+	view->num_headers  = (size_t)record->num_headers;
+	view->body         = payload + record->key_size + record->headers_size;
+	view->body_size    = (size_t)record->body_size;
+	view->expires      = slot->expires;
+	disk->pins[disk->num_pins++] = slot->offset;
+	return true;
+}
+
+void http_disk_cache_unpin( http_disk_cache* disk, unsigned long long offset )
+{
+	for( unsigned int i = 0; i < disk->num_pins; ++i )
+		if( disk->pins[i] == offset )
+		{
+			disk->pins[i] = disk->pins[--disk->num_pins];
+			return;
+		}
+}
+
+bool http_disk_cache_store( http_disk_cache* disk,
+							const char* key,
+							unsigned int hash,
+							const char* headers,
+							size_t headers_size,
+							size_t num_headers,
+							const void* body,
+							size_t body_size,
+							long long expires,
+							unsigned long long* evicted )
+{
+	if( http_disk_append( disk, key, hash, headers, headers_size, num_headers, body, body_size, expires, evicted ) )
+		return true;
+
+	// ... the response of key is outdated by this one, don't keep serving it ...
+	http_disk_cache_remove( disk, key, hash );
+	return false;
+}
+
+void http_disk_cache_set_expires( http_disk_cache* disk, const char* key, unsigned int hash, unsigned long long offset, long long expires )
+{
+	http_disk_slot* slot = http_disk_find_slot( disk, key, hash );
+	if( slot && slot->offset == offset )
+		slot->expires = expires;
+}
+
+void http_disk_cache_remove( http_disk_cache* disk, const char* key, unsigned int hash )
+{
+	if( http_disk_slot* slot = http_disk_find_slot( disk, key, hash ) )
+		http_disk_remove_slot( disk, slot );
+}
+
+void http_disk_cache_clear( http_disk_cache* disk )
+{
+	// ... records are left in the ring as dead records, pinned ones might still be read ...
+	memset( disk->slots, 0x0, (size_t)disk->index->num_slots * sizeof( http_disk_slot ) );
+	disk->index->entries = 0;
+	disk->index->bytes = 0;
+}
+
+void http_disk_cache_usage( http_disk_cache* disk, unsigned int* entries, size_t* bytes )
+{
+	*entries = disk->index->entries;
+	*bytes = (size_t)disk->index->bytes;
+}
+
+#endif
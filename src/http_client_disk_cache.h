@@ -0,0 +1,111 @@
+/*
+    Simple http-client written to be an drop-in code, focus is to be small
+    and easy to use but maybe not efficient.
+
+    version 1.0, June, 2014
+
+	Copyright (C) 2014- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+#ifndef HTTP_CLIENT_DISK_CACHE_H_INCLUDED
+#define HTTP_CLIENT_DISK_CACHE_H_INCLUDED
+
+/**
+ * Persistent storage of a http_client_cache, not part of the public api.
+ *
+ * Responses are appended as records to a data file used as a ring, "<path>.dat", and found through an open-addressing
+ * hash table in an index file, "<path>.idx". Both files are memory-mapped so opening the cache only maps the index
+ * and hits are read straight from the mapping. When the ring is full the oldest records are evicted, records read
+ * close to eviction are moved to the head of the ring to approximate least recently used eviction.
+ *
+ * None of the functions are thread-safe, the owning cache serializes all calls.
+ */
+
+#include <http_client/http_client.h>
+
+struct http_disk_cache;
+
+/**
+ * A record found in the disk cache, all pointers point into the mapping and stays valid until the record is unpinned.
+ */
+struct http_disk_view
+{
+	unsigned long long offset;   ///< offset of the record, identifies the record when unpinning or refreshing it.
+	const char* key;
+	const char* headers;         ///< headers as num_headers pairs of '\0'-terminated name and value.
+	size_t headers_size;
+	size_t num_headers;
+	const void* body;
+	size_t body_size;
+	long long expires;           ///< unix time in ms the response is fresh until.
+};
+
+/**
+ * Open or create the disk cache at path with a data file of data_size bytes. An existing cache of another size or
+ * that can not be read is discarded.
+ *
+ * @return HTTP_CLIENT_OK on success, HTTP_CLIENT_FILE_ERROR if the files could not be opened or are used by another
+ *         process and HTTP_CLIENT_NOT_SUPPORTED if the platform has no support for it.
+ */
+http_client_result http_disk_cache_open( http_disk_cache** disk, const char* path, size_t data_size );
+void http_disk_cache_close( http_disk_cache* disk );
+
+/**
+ * Return current unix time in ms, used for expiry times as they need to survive a restart.
+ */
+long long http_disk_cache_time();
+
+/**
+ * Find key and pin its record so that it is not overwritten until http_disk_cache_unpin() is called.
+ */
+bool http_disk_cache_find( http_disk_cache* disk, const char* key, unsigned int hash, http_disk_view* view );
+void http_disk_cache_unpin( http_disk_cache* disk, unsigned long long offset );
+
+/**
+ * Store a response as key, replacing any earlier record with the same key. Returns false if it did not fit, *evicted
+ * is incremented for each record evicted to make room.
+ */
+bool http_disk_cache_store( http_disk_cache* disk,
+							const char* key,
+							unsigned int hash,
+							const char* headers,
+							size_t headers_size,
+							size_t num_headers,
+							const void* body,
+							size_t body_size,
+							long long expires,
+							unsigned long long* evicted );
+
+/**
+ * Set the expiry of the record at offset if it is still the record of key.
+ */
+void http_disk_cache_set_expires( http_disk_cache* disk, const char* key, unsigned int hash, unsigned long long offset, long long expires );
+
+void http_disk_cache_remove( http_disk_cache* disk, const char* key, unsigned int hash );
+
+/**
+ * Remove all records.
+ */
+void http_disk_cache_clear( http_disk_cache* disk );
+
+void http_disk_cache_usage( http_disk_cache* disk, unsigned int* entries, size_t* bytes );
+
+#endif // HTTP_CLIENT_DISK_CACHE_H_INCLUDED
@@ -0,0 +1,712 @@
+/*
+    Simple http-client written to be an drop-in code, focus is to be small
+    and easy to use but maybe not efficient.
+
+    version 1.0, June, 2014
+
+	Copyright (C) 2014- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+#include <http_client/http_client_download.h>
+#include "http_client_internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined( _MSC_VER )
+#  include <io.h>
+#  include <fcntl.h>
+#  include <sys/stat.h>
+	typedef HANDLE http_download_thread;
+#else
+#  include <fcntl.h>
+	typedef pthread_t http_download_thread;
+#endif
+
+#define HTTP_DOWNLOAD_MAX_CONNECTIONS 32
+#define HTTP_DOWNLOAD_STAGING_SIZE    (64 * 1024)
+#define HTTP_DOWNLOAD_MAX_VALIDATOR   256
+#define HTTP_DOWNLOAD_CHECKPOINT      (4 * 1024 * 1024)
+#define HTTP_DOWNLOAD_UNKNOWN_SIZE    (~0ULL)
+#define HTTP_DOWNLOAD_JOURNAL_MAGIC   0x4a444348 // "HCDJ"
+#define HTTP_DOWNLOAD_JOURNAL_VERSION 1
+
+/**
+ * State of one download shared by all connections working on it.
+ */
+struct http_download
+{
+	http_client_t client;   ///< client passed by the user, urls of the other connections point into it.
+	const char* resource;
+	char validator[HTTP_DOWNLOAD_MAX_VALIDATOR]; ///< ETag or Last-Modified sent as If-Range, empty if none.
+
+	char*  buffer;          ///< output buffer, NULL when downloading to fd.
+	size_t buffer_size;
+	int    fd;
+
+	size_t size;            ///< size of the resource from the HEAD.
+	size_t segment_size;
+	size_t num_segments;
+
+	http_client_mutex mutex;
+	size_t next_segment;    ///< next segment to be fetched by any connection.
+	bool   stop;            ///< set on the first failure, no more segments are started.
+	bool   fallback;        ///< a range request was answered with something else than the range.
+	http_client_result result; ///< first error, not counting range requests that caused fallback.
+};
+
+/**
+ * Extra connection of a download, connected before any thread is started and run by its own thread.
+ */
+struct http_download_conn
+{
+	http_download* download;
+	http_client_t client;
+};
+
+/**
+ * Sink writing a body, or one range of it, to its offset in the output of a download.
+ */
+struct http_download_sink
+{
+	http_body_sink sink;
+	http_download* download;
+	http_client_t client;
+	size_t offset;          ///< where the next received byte goes.
+	size_t end;             ///< end of the range, or of the output when receiving the full body.
+	bool   ranged;
+	char*  staging;         ///< memory to receive into before writing to fd.
+};
+
+/**
+ * Parse "bytes <first>-<last>/<complete-length>" of a Content-Range header.
+ */
+static bool http_download_parse_content_range( const http_client_header* header, size_t* first, size_t* last, size_t* total )
+{
+	char value[128];
+	if( header == 0x0 || header->value_len >= sizeof( value ) )
+		return false;
+	memcpy( value, header->value, header->value_len );
+	value[header->value_len] = '\0';
+
+	unsigned long long f, l, t;
+	if( sscanf( value, "bytes %llu-%llu/%llu", &f, &l, &t ) != 3 )
+		return false;
+	*first = (size_t)f;
+	*last  = (size_t)l;
+	*total = (size_t)t;
+	return true;
+}
+
+static http_client_result http_download_sink_begin( http_body_sink* self, const http_response* response )
+{
+	http_download_sink* s = (http_download_sink*)self;
+	http_download* d = s->download;
+	if( !s->ranged )
+	{
+		if( response->has_content_length && !response->chunked && response->content_encoding == 0 && response->content_length > s->end )
+			return d->buffer ? HTTP_CLIENT_BUFFER_TOO_SMALL : HTTP_CLIENT_OK;
+		return HTTP_CLIENT_OK;
+	}
+
+	size_t first, last, total;
+	if( response->status == 206 &&
+		response->content_encoding == 0 &&
+		http_download_parse_content_range( http_client_get_header( s->client, HTTP_CLIENT_HEADER_CONTENT_RANGE ), &first, &last, &total ) &&
+		first == s->offset && last + 1 == s->end && total == d->size )
+		return HTTP_CLIENT_OK;
+
+	// ... Range ignored, or If-Range failed as the resource changed, get it all in one go instead ...
+	http_client_mutex_lock( &d->mutex );
+	d->fallback = true;
+	http_client_mutex_unlock( &d->mutex );
+	return HTTP_CLIENT_ABORTED;
+}
+
+static http_client_result http_download_sink_reserve( http_body_sink* self, size_t, void** dst, size_t* avail )
+{
+	http_download_sink* s = (http_download_sink*)self;
+	if( s->offset == s->end )
+		return s->download->buffer ? HTTP_CLIENT_BUFFER_TOO_SMALL : HTTP_CLIENT_INTERNAL_ERROR;
+
+	size_t left = s->end - s->offset;
+	if( s->download->buffer )
+	{
+		*dst   = s->download->buffer + s->offset;
+		*avail = left;
+	}
+	else
+	{
+		*dst   = s->staging;
+		*avail = left < HTTP_DOWNLOAD_STAGING_SIZE ? left : HTTP_DOWNLOAD_STAGING_SIZE;
+	}
+	return HTTP_CLIENT_OK;
+}
+
+/**
+ * Write size bytes of data to fd at offset, fd is the output or journal of d.
+ */
+static http_client_result http_download_write_file( http_download* d, int fd, const char* data, size_t size, size_t offset )
+{
+	while( size > 0 )
+	{
+#if defined( _MSC_VER )
+		// ... no pwrite(), seek and write need to be done as one ...
+		http_client_mutex_lock( &d->mutex );
+		int res = -1;
+		if( _lseeki64( fd, (__int64)offset, SEEK_SET ) >= 0 )
+			res = _write( fd, data, (unsigned int)size );
+		http_client_mutex_unlock( &d->mutex );
+#else
+		(void)d;
+		ssize_t res = pwrite( fd, data, size, (off_t)offset );
+#endif
+		if( res < 0 && errno == EINTR )
+			continue;
+		if( res <= 0 )
+			return HTTP_CLIENT_FILE_ERROR;
+		data   += res;
+		offset += (size_t)res;
+		size   -= (size_t)res;
+	}
+	return HTTP_CLIENT_OK;
+}
+
+static http_client_result http_download_sink_write( http_body_sink* self, const void* data, size_t size )
+{
+	http_download_sink* s = (http_download_sink*)self;
+	http_download* d = s->download;
+	if( size > s->end - s->offset )
+		return d->buffer ? HTTP_CLIENT_BUFFER_TOO_SMALL : HTTP_CLIENT_INTERNAL_ERROR;
+
+	if( d->buffer )
+	{
+		if( data != d->buffer + s->offset )
+			memcpy( d->buffer + s->offset, data, size );
+	}
+	else
+	{
+		http_client_result res = http_download_write_file( d, d->fd, (const char*)data, size, s->offset );
+		if( res != HTTP_CLIENT_OK )
+			return res;
+	}
+	s->offset += size;
+	return HTTP_CLIENT_OK;
+}
+
+/**
+ * Fetch segments of d on client until all are taken or the download is stopped.
+ */
+static void http_download_work( http_download* d, http_client_t client )
+{
+	char* staging = 0x0;
+	if( d->buffer == 0x0 )
+	{
+		staging = (char*)malloc( HTTP_DOWNLOAD_STAGING_SIZE );
+		if( staging == 0x0 )
+			return;
+	}
+
+	while( true )
+	{
+		http_client_mutex_lock( &d->mutex );
+		size_t segment = d->next_segment;
+		bool done = d->stop || segment == d->num_segments;
+		if( !done )
+			++d->next_segment;
+		http_client_mutex_unlock( &d->mutex );
+		if( done )
+			break;
+
+		size_t first = segment * d->segment_size;
+		size_t last  = first + d->segment_size < d->size ? first + d->segment_size - 1 : d->size - 1;
+
+		char headers[64 + HTTP_DOWNLOAD_MAX_VALIDATOR];
+		if( d->validator[0] )
+			snprintf( headers, sizeof( headers ), "Range: bytes=%llu-%llu\r\nIf-Range: %s\r\n", (unsigned long long)first, (unsigned long long)last, d->validator );
+		else
+			snprintf( headers, sizeof( headers ), "Range: bytes=%llu-%llu\r\n", (unsigned long long)first, (unsigned long long)last );
+
+		http_download_sink sink = { { http_download_sink_begin, http_download_sink_reserve, http_download_sink_write }, d, client, first, last + 1, true, staging };
+		http_response response;
+		http_client_result res = http_client_request( client, "GET", d->resource, headers, &sink.sink, &response );
+		if( res == HTTP_CLIENT_OK && sink.offset != sink.end )
+			res = HTTP_CLIENT_CONNECTION_LOST;
+		if( res != HTTP_CLIENT_OK )
+		{
+			http_client_mutex_lock( &d->mutex );
+			if( !d->fallback && d->result == HTTP_CLIENT_OK )
+				d->result = res;
+			d->stop = true;
+			http_client_mutex_unlock( &d->mutex );
+			break;
+		}
+	}
+
+	free( staging );
+}
+
+#if defined( _MSC_VER )
+static DWORD WINAPI http_download_thread_main( LPVOID arg )
+#else
+static void* http_download_thread_main( void* arg )
+#endif
+{
+	http_download_conn* conn = (http_download_conn*)arg;
+	http_download_work( conn->download, conn->client );
+	return 0;
+}
+
+/**
+ * GET the full body of d on its client in one request.
+ */
+static http_client_result http_download_single( http_download* d, size_t* msgbody_size )
+{
+	char* staging = 0x0;
+	if( d->buffer == 0x0 )
+	{
+		staging = (char*)malloc( HTTP_DOWNLOAD_STAGING_SIZE );
+		if( staging == 0x0 )
+			return HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+	}
+
+	http_download_sink sink = { { http_download_sink_begin, http_download_sink_reserve, http_download_sink_write }, d, d->client, 0, d->buffer ? d->buffer_size : (size_t)-1, false, staging };
+	http_response response;
+	http_client_result res = http_client_request( d->client, "GET", d->resource, d->client->accept_encoding, &sink.sink, &response );
+	*msgbody_size = sink.offset;
+	free( staging );
+	return res;
+}
+
+/**
+ * Copy the value of header id of the last response of client to dst as a '\0'-terminated string, return false if
+ * missing or too long.
+ */
+static bool http_download_copy_header( http_client_t client, http_client_header_id id, char* dst, size_t dst_size )
+{
+	const http_client_header* header = http_client_get_header( client, id );
+	if( header == 0x0 || header->value_len >= dst_size )
+		return false;
+	memcpy( dst, header->value, header->value_len );
+	dst[header->value_len] = '\0';
+	return true;
+}
+
+/**
+ * Copy the validator of the last response of client usable with If-Range to dst, the ETag if it is strong otherwise
+ * Last-Modified. dst is set to "" if there is none.
+ */
+static void http_download_copy_validator( http_client_t client, char* dst, size_t dst_size )
+{
+	// ... a weak etag can not be used with If-Range, rfc 9110 section 13.1.5 ...
+	if( http_download_copy_header( client, HTTP_CLIENT_HEADER_ETAG, dst, dst_size ) && strncmp( dst, "W/", 2 ) != 0 )
+		return;
+	if( !http_download_copy_header( client, HTTP_CLIENT_HEADER_LAST_MODIFIED, dst, dst_size ) )
+		dst[0] = '\0';
+}
+
+static http_client_result http_download_run( http_download* d, const http_client_download_config* config, size_t* msgbody_size )
+{
+	*msgbody_size = 0;
+
+	unsigned int connections = config && config->connections ? config->connections : 4;
+	if( connections > HTTP_DOWNLOAD_MAX_CONNECTIONS )
+		connections = HTTP_DOWNLOAD_MAX_CONNECTIONS;
+	d->segment_size = config && config->segment_size ? config->segment_size : 1024 * 1024;
+
+	// ... a server not allowing HEAD might still allow GET ...
+	size_t size;
+	http_client_result res = http_client_head( d->client, d->resource, &size );
+	if( res >= HTTP_CLIENT_RESULT_300_MULTIPLE_CHOICES )
+		return http_download_single( d, msgbody_size );
+	if( res != HTTP_CLIENT_OK )
+		return res;
+
+	char value[64];
+	bool ranged = connections > 1 &&
+				  http_client_get_header( d->client, HTTP_CLIENT_HEADER_CONTENT_LENGTH ) != 0x0 &&
+				  http_download_copy_header( d->client, HTTP_CLIENT_HEADER_ACCEPT_RANGES, value, sizeof( value ) ) &&
+				  http_client_header_has_token( value, "bytes" ) &&
+				  // ... ranges of a content-coded response are ranges of the coded bytes ...
+				  http_client_get_header( d->client, HTTP_CLIENT_HEADER_CONTENT_ENCODING ) == 0x0 &&
+				  size > d->segment_size;
+	if( !ranged )
+		return http_download_single( d, msgbody_size );
+	if( d->buffer && size > d->buffer_size )
+		return HTTP_CLIENT_BUFFER_TOO_SMALL;
+
+	http_download_copy_validator( d->client, d->validator, sizeof( d->validator ) );
+	d->size = size;
+	d->num_segments = ( size + d->segment_size - 1 ) / d->segment_size;
+	d->next_segment = 0;
+	d->stop = false;
+	d->fallback = false;
+	d->result = HTTP_CLIENT_OK;
+	if( connections > d->num_segments )
+		connections = (unsigned int)d->num_segments;
+
+	// ... all connections are made before any request is sent, cloning reads the address of d->client that a request
+	//     on it could change by reconnecting. A connection that fails to connect leaves its segments to the others ...
+	http_download_conn conns[HTTP_DOWNLOAD_MAX_CONNECTIONS];
+	unsigned int num_conns = 0;
+	for( unsigned int i = 1; i < connections; ++i )
+	{
+		conns[num_conns].download = d;
+		if( http_client_clone( d->client, &conns[num_conns].client ) == HTTP_CLIENT_OK )
+			++num_conns;
+	}
+
+	http_download_thread threads[HTTP_DOWNLOAD_MAX_CONNECTIONS];
+	unsigned int num_threads = 0;
+	for( ; num_threads < num_conns; ++num_threads )
+	{
+#if defined( _MSC_VER )
+		threads[num_threads] = CreateThread( 0x0, 0, http_download_thread_main, &conns[num_threads], 0, 0x0 );
+		if( threads[num_threads] == 0x0 )
+			break;
+#else
+		if( pthread_create( &threads[num_threads], 0x0, http_download_thread_main, &conns[num_threads] ) != 0 )
+			break;
+#endif
+	}
+
+	// ... client itself is one of the connections ...
+	http_download_work( d, d->client );
+
+	for( unsigned int i = 0; i < num_threads; ++i )
+	{
+#if defined( _MSC_VER )
+		WaitForSingleObject( threads[i], INFINITE );
+		CloseHandle( threads[i] );
+#else
+		pthread_join( threads[i], 0x0 );
+#endif
+	}
+	for( unsigned int i = 0; i < num_conns; ++i )
+	{
+		http_client_disconnect( conns[i].client );
+		free( conns[i].client );
+	}
+	if( d->fallback )
+		return http_download_single( d, msgbody_size );
+	if( d->result != HTTP_CLIENT_OK )
+		return d->result;
+	if( d->next_segment != d->num_segments )
+		return HTTP_CLIENT_MEMORY_ALLOC_ERROR; // ... no connection could allocate its staging buffer ...
+	*msgbody_size = size;
+	return HTTP_CLIENT_OK;
+}
+
+/**
+ * Sidecar journal of a resumable download, stored as is in "<path>.journal". offset is only advanced once the body
+ * up to it is synced to the file, so a journal never claims more than what survived a crash.
+ */
+struct http_download_journal
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned long long offset; ///< bytes of the body in the file.
+	unsigned long long size;   ///< size of the complete body, HTTP_DOWNLOAD_UNKNOWN_SIZE if not known.
+	char validator[HTTP_DOWNLOAD_MAX_VALIDATOR]; ///< ETag or Last-Modified the body is resumed with, empty if it can not be resumed.
+};
+
+static int http_download_open( const char* path )
+{
+#if defined( _MSC_VER )
+	return _open( path, _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE );
+#else
+	return open( path, O_RDWR | O_CREAT, 0644 );
+#endif
+}
+
+static void http_download_close( int fd )
+{
+#if defined( _MSC_VER )
+	_close( fd );
+#else
+	close( fd );
+#endif
+}
+
+static bool http_download_truncate( int fd, unsigned long long size )
+{
+#if defined( _MSC_VER )
+	return _chsize_s( fd, (__int64)size ) == 0;
+#else
+	return ftruncate( fd, (off_t)size ) == 0;
+#endif
+}
+
+static bool http_download_sync( int fd )
+{
+#if defined( _MSC_VER )
+	return _commit( fd ) == 0;
+#elif defined( __APPLE__ )
+	return fsync( fd ) == 0;
+#else
+	return fdatasync( fd ) == 0;
+#endif
+}
+
+static unsigned long long http_download_file_size( int fd )
+{
+#if defined( _MSC_VER )
+	__int64 size = _lseeki64( fd, 0, SEEK_END );
+#else
+	off_t size = lseek( fd, 0, SEEK_END );
+#endif
+	return size < 0 ? 0 : (unsigned long long)size;
+}
+
+/**
+ * Read the journal in fd, returns false if there is none or it is not one written by this version.
+ */
+static bool http_download_read_journal( int fd, http_download_journal* journal )
+{
+#if defined( _MSC_VER )
+	int res = _lseeki64( fd, 0, SEEK_SET ) < 0 ? -1 : _read( fd, journal, sizeof( http_download_journal ) );
+#else
+	ssize_t res = pread( fd, journal, sizeof( http_download_journal ), 0 );
+#endif
+	return res == (int)sizeof( http_download_journal ) &&
+		   journal->magic == HTTP_DOWNLOAD_JOURNAL_MAGIC &&
+		   journal->version == HTTP_DOWNLOAD_JOURNAL_VERSION &&
+		   memchr( journal->validator, '\0', sizeof( journal->validator ) ) != 0x0;
+}
+
+/**
+ * Sink writing a body to the file of a resumable download, either all of it or the rest of it from where the journal
+ * says the last attempt stopped.
+ */
+struct http_resume_sink
+{
+	http_body_sink sink;
+	http_download* download;
+	http_download_journal* journal;
+	int    journal_fd;
+	size_t offset;             ///< where the next received byte goes.
+	bool   restart;            ///< the range received did not continue the file, start over.
+	char   staging[HTTP_DOWNLOAD_STAGING_SIZE];
+};
+
+/**
+ * Sync the body written so far and record it in the journal.
+ */
+static http_client_result http_resume_checkpoint( http_resume_sink* s )
+{
+	if( !http_download_sync( s->download->fd ) )
+		return HTTP_CLIENT_FILE_ERROR;
+	s->journal->offset = s->offset;
+	return http_download_write_file( s->download, s->journal_fd, (const char*)s->journal, sizeof( http_download_journal ), 0 );
+}
+
+static http_client_result http_resume_sink_begin( http_body_sink* self, const http_response* response )
+{
+	http_resume_sink* s = (http_resume_sink*)self;
+	http_client_t client = s->download->client;
+	http_download_journal* journal = s->journal;
+
+	if( response->status == 206 )
+	{
+		size_t first, last, total;
+		if( !http_download_parse_content_range( http_client_get_header( client, HTTP_CLIENT_HEADER_CONTENT_RANGE ), &first, &last, &total ) ||
+			first != journal->offset || last + 1 != total ||
+			( journal->size != HTTP_DOWNLOAD_UNKNOWN_SIZE && total != journal->size ) )
+		{
+			s->restart = true;
+			return HTTP_CLIENT_ABORTED;
+		}
+		journal->size = total;
+	}
+	else
+	{
+		// ... the full body, because nothing was resumed or If-Range found that the resource changed ...
+		if( !http_download_truncate( s->download->fd, 0 ) )
+			return HTTP_CLIENT_FILE_ERROR;
+		journal->offset = 0;
+		journal->size = response->has_content_length && !response->chunked ? response->content_length : HTTP_DOWNLOAD_UNKNOWN_SIZE;
+		http_download_copy_validator( client, journal->validator, sizeof( journal->validator ) );
+	}
+
+	// ... offsets of a decompressed body do not match ranges of the coded one ...
+	if( response->content_encoding != 0 )
+		journal->validator[0] = '\0';
+
+	s->offset = (size_t)journal->offset;
+	return http_download_write_file( s->download, s->journal_fd, (const char*)journal, sizeof( http_download_journal ), 0 );
+}
+
+static http_client_result http_resume_sink_reserve( http_body_sink* self, size_t, void** dst, size_t* avail )
+{
+	http_resume_sink* s = (http_resume_sink*)self;
+	*dst   = s->staging;
+	*avail = sizeof( s->staging );
+	return HTTP_CLIENT_OK;
+}
+
+static http_client_result http_resume_sink_write( http_body_sink* self, const void* data, size_t size )
+{
+	http_resume_sink* s = (http_resume_sink*)self;
+	http_client_result res = http_download_write_file( s->download, s->download->fd, (const char*)data, size, s->offset );
+	if( res != HTTP_CLIENT_OK )
+		return res;
+	s->offset += size;
+	if( s->offset - s->journal->offset >= HTTP_DOWNLOAD_CHECKPOINT )
+		return http_resume_checkpoint( s );
+	return HTTP_CLIENT_OK;
+}
+
+/**
+ * GET resource to the file of d, continuing from what journal says is already in it if possible.
+ */
+static http_client_result http_download_resume_run( http_download* d, http_resume_sink* sink, size_t* msgbody_size )
+{
+	http_download_journal* journal = sink->journal;
+	if( !http_download_read_journal( sink->journal_fd, journal ) || journal->offset > http_download_file_size( d->fd ) )
+	{
+		memset( journal, 0x0, sizeof( http_download_journal ) );
+		journal->magic   = HTTP_DOWNLOAD_JOURNAL_MAGIC;
+		journal->version = HTTP_DOWNLOAD_JOURNAL_VERSION;
+		journal->size    = HTTP_DOWNLOAD_UNKNOWN_SIZE;
+	}
+
+	for( int attempt = 0; attempt < 2; ++attempt )
+	{
+		// ... no Accept-Encoding, a content-coded body could not be resumed. Without a validator there is no telling
+		//     if what is in the file is still part of the resource ...
+		char headers[64 + HTTP_DOWNLOAD_MAX_VALIDATOR];
+		const char* request_headers = 0x0;
+		if( journal->offset > 0 && journal->validator[0] != '\0' )
+		{
+			snprintf( headers, sizeof( headers ), "Range: bytes=%llu-\r\nIf-Range: %s\r\n", journal->offset, journal->validator );
+			request_headers = headers;
+		}
+		else
+			journal->offset = 0;
+
+		sink->offset  = (size_t)journal->offset;
+		sink->restart = false;
+		http_response response;
+		http_client_result res = http_client_request( d->client, "GET", d->resource, request_headers, &sink->sink, &response );
+		if( res == HTTP_CLIENT_OK )
+		{
+			if( !http_download_truncate( d->fd, sink->offset ) || !http_download_sync( d->fd ) )
+				return HTTP_CLIENT_FILE_ERROR;
+			*msgbody_size = sink->offset;
+			return HTTP_CLIENT_OK;
+		}
+
+		// ... file is not what the journal says, or the server can not continue it, start over ...
+		if( attempt == 0 && request_headers == headers && ( sink->restart || res == HTTP_CLIENT_RESULT_416_REQUESTED_RANGE_NOT_SATISFIABLE ) )
+		{
+			journal->offset = 0;
+			journal->validator[0] = '\0';
+			continue;
+		}
+
+		// ... keep what was received for the next attempt ...
+		if( sink->offset > journal->offset && journal->validator[0] != '\0' )
+			http_resume_checkpoint( sink );
+		return res;
+	}
+	return HTTP_CLIENT_INTERNAL_ERROR;
+}
+
+http_client_result http_client_download( http_client_t client, const char* resource, const http_client_download_config* config, void* buffer, size_t buffer_size, size_t* msgbody_size )
+{
+	http_download d;
+	d.client = client;
+	d.resource = resource;
+	d.buffer = (char*)buffer;
+	d.buffer_size = buffer_size;
+	d.fd = -1;
+	http_client_mutex_init( &d.mutex );
+	http_client_result res = http_download_run( &d, config, msgbody_size );
+	http_client_mutex_destroy( &d.mutex );
+	return res;
+}
+
+http_client_result http_client_download_file( http_client_t client, const char* resource, const http_client_download_config* config, int fd, size_t* msgbody_size )
+{
+	http_download d;
+	d.client = client;
+	d.resource = resource;
+	d.buffer = 0x0;
+	d.buffer_size = 0;
+	d.fd = fd;
+	http_client_mutex_init( &d.mutex );
+	http_client_result res = http_download_run( &d, config, msgbody_size );
+	http_client_mutex_destroy( &d.mutex );
+	return res;
+}
+
+http_client_result http_client_download_resume( http_client_t client, const char* resource, const char* path, size_t* msgbody_size )
+{
+	*msgbody_size = 0;
+
+	char journal_path[1024];
+	if( snprintf( journal_path, sizeof( journal_path ), "%s.journal", path ) >= (int)sizeof( journal_path ) )
+		return HTTP_CLIENT_FILE_ERROR;
+
+	http_resume_sink* sink = (http_resume_sink*)malloc( sizeof( http_resume_sink ) );
+	if( sink == 0x0 )
+		return HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+
+	http_download d;
+	http_download_journal journal;
+	d.client = client;
+	d.resource = resource;
+	d.buffer = 0x0;
+	d.buffer_size = 0;
+	d.fd = http_download_open( path );
+	sink->journal_fd = http_download_open( journal_path );
+	if( d.fd < 0 || sink->journal_fd < 0 )
+	{
+		if( d.fd >= 0 )             http_download_close( d.fd );
+		if( sink->journal_fd >= 0 ) http_download_close( sink->journal_fd );
+		free( sink );
+		return HTTP_CLIENT_FILE_ERROR;
+	}
+
+	http_body_sink callbacks = { http_resume_sink_begin, http_resume_sink_reserve, http_resume_sink_write };
+	sink->sink = callbacks;
+	sink->download = &d;
+	sink->journal = &journal;
+
+	http_client_mutex_init( &d.mutex );
+	http_client_result res = http_download_resume_run( &d, sink, msgbody_size );
+	http_client_mutex_destroy( &d.mutex );
+
+	http_download_close( sink->journal_fd );
+	http_download_close( d.fd );
+	free( sink );
+
+	// ... a complete body needs no journal, and neither does one that can not be continued ...
+	if( res == HTTP_CLIENT_OK || journal.offset == 0 || journal.validator[0] == '\0' )
+#if defined( _MSC_VER )
+		_unlink( journal_path );
+#else
+		unlink( journal_path );
+#endif
+	return res;
+}
@@ -0,0 +1,184 @@
+/*
+    Simple http-client written to be an drop-in code, focus is to be small
+    and easy to use but maybe not efficient.
+
+    version 1.0, June, 2014
+
+	Copyright (C) 2014- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+// generated by tools/gen_header_hash.py, do not edit.
+
+#define HTTP_CLIENT_HEADER_MIN_NAME_LENGTH 3
+#define HTTP_CLIENT_HEADER_MAX_NAME_LENGTH 32
+
+struct http_header_hash_entry
+{
+	const char*   name;   ///< lowercase name.
+	unsigned char length; ///< length of name, 0 for an empty slot.
+	unsigned char id;
+};
+
+/**
+ * Slot of name in http_header_hash_table, length needs to be in [HTTP_CLIENT_HEADER_MIN_NAME_LENGTH, HTTP_CLIENT_HEADER_MAX_NAME_LENGTH].
+ * Letters are folded to lowercase so the hash is case-insensitive.
+ */
+static inline unsigned int http_header_hash( const char* name, size_t length )
+{
+	unsigned int h = (unsigned int)length * 253u
+	               + ( (unsigned int)(unsigned char)name[0] | 0x20 ) * 131u
+	               + ( (unsigned int)(unsigned char)name[length / 2] | 0x20 ) * 87u
+	               + ( (unsigned int)(unsigned char)name[length - 2] | 0x20 ) * 143u
+	               + ( (unsigned int)(unsigned char)name[length - 1] | 0x20 ) * 210u;
+	return h % 128u;
+}
+
+static const http_header_hash_entry http_header_hash_table[128] =
+{
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ "access-control-max-age", 22, HTTP_CLIENT_HEADER_ACCESS_CONTROL_MAX_AGE },
+	{ 0x0, 0, 0 },
+	{ "vary", 4, HTTP_CLIENT_HEADER_VARY },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ "accept-ranges", 13, HTTP_CLIENT_HEADER_ACCEPT_RANGES },
+	{ 0x0, 0, 0 },
+	{ "expires", 7, HTTP_CLIENT_HEADER_EXPIRES },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ "x-content-type-options", 22, HTTP_CLIENT_HEADER_X_CONTENT_TYPE_OPTIONS },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ "content-language", 16, HTTP_CLIENT_HEADER_CONTENT_LANGUAGE },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ "proxy-authenticate", 18, HTTP_CLIENT_HEADER_PROXY_AUTHENTICATE },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ "access-control-expose-headers", 29, HTTP_CLIENT_HEADER_ACCESS_CONTROL_EXPOSE_HEADERS },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ "access-control-allow-headers", 28, HTTP_CLIENT_HEADER_ACCESS_CONTROL_ALLOW_HEADERS },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ "access-control-allow-credentials", 32, HTTP_CLIENT_HEADER_ACCESS_CONTROL_ALLOW_CREDENTIALS },
+	{ "warning", 7, HTTP_CLIENT_HEADER_WARNING },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ "strict-transport-security", 25, HTTP_CLIENT_HEADER_STRICT_TRANSPORT_SECURITY },
+	{ 0x0, 0, 0 },
+	{ "www-authenticate", 16, HTTP_CLIENT_HEADER_WWW_AUTHENTICATE },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ "date", 4, HTTP_CLIENT_HEADER_DATE },
+	{ 0x0, 0, 0 },
+	{ "pragma", 6, HTTP_CLIENT_HEADER_PRAGMA },
+	{ 0x0, 0, 0 },
+	{ "content-security-policy", 23, HTTP_CLIENT_HEADER_CONTENT_SECURITY_POLICY },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ "content-encoding", 16, HTTP_CLIENT_HEADER_CONTENT_ENCODING },
+	{ 0x0, 0, 0 },
+	{ "upgrade", 7, HTTP_CLIENT_HEADER_UPGRADE },
+	{ 0x0, 0, 0 },
+	{ "cache-control", 13, HTTP_CLIENT_HEADER_CACHE_CONTROL },
+	{ "via", 3, HTTP_CLIENT_HEADER_VIA },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ "etag", 4, HTTP_CLIENT_HEADER_ETAG },
+	{ 0x0, 0, 0 },
+	{ "last-modified", 13, HTTP_CLIENT_HEADER_LAST_MODIFIED },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ "access-control-allow-methods", 28, HTTP_CLIENT_HEADER_ACCESS_CONTROL_ALLOW_METHODS },
+	{ 0x0, 0, 0 },
+	{ "x-frame-options", 15, HTTP_CLIENT_HEADER_X_FRAME_OPTIONS },
+	{ 0x0, 0, 0 },
+	{ "server", 6, HTTP_CLIENT_HEADER_SERVER },
+	{ "content-range", 13, HTTP_CLIENT_HEADER_CONTENT_RANGE },
+	{ "link", 4, HTTP_CLIENT_HEADER_LINK },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ "location", 8, HTTP_CLIENT_HEADER_LOCATION },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ "content-type", 12, HTTP_CLIENT_HEADER_CONTENT_TYPE },
+	{ "content-disposition", 19, HTTP_CLIENT_HEADER_CONTENT_DISPOSITION },
+	{ 0x0, 0, 0 },
+	{ "keep-alive", 10, HTTP_CLIENT_HEADER_KEEP_ALIVE },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ "transfer-encoding", 17, HTTP_CLIENT_HEADER_TRANSFER_ENCODING },
+	{ "trailer", 7, HTTP_CLIENT_HEADER_TRAILER },
+	{ "content-length", 14, HTTP_CLIENT_HEADER_CONTENT_LENGTH },
+	{ "allow", 5, HTTP_CLIENT_HEADER_ALLOW },
+	{ 0x0, 0, 0 },
+	{ "access-control-allow-origin", 27, HTTP_CLIENT_HEADER_ACCESS_CONTROL_ALLOW_ORIGIN },
+	{ "content-location", 16, HTTP_CLIENT_HEADER_CONTENT_LOCATION },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ "connection", 10, HTTP_CLIENT_HEADER_CONNECTION },
+	{ 0x0, 0, 0 },
+	{ "retry-after", 11, HTTP_CLIENT_HEADER_RETRY_AFTER },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ "set-cookie", 10, HTTP_CLIENT_HEADER_SET_COOKIE },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ "alt-svc", 7, HTTP_CLIENT_HEADER_ALT_SVC },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ 0x0, 0, 0 },
+	{ "age", 3, HTTP_CLIENT_HEADER_AGE },
+	{ 0x0, 0, 0 },
+};
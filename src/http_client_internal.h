@@ -0,0 +1,388 @@
+/*
+    Simple http-client written to be an drop-in code, focus is to be small
+    and easy to use but maybe not efficient.
+
+    version 1.0, June, 2014
+
+	Copyright (C) 2014- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+#ifndef HTTP_CLIENT_INTERNAL_H_INCLUDED
+#define HTTP_CLIENT_INTERNAL_H_INCLUDED
+
+/**
+ * Declarations shared between the translation units of http_client, not part of the public api.
+ */
+
+#include <http_client/http_client.h>
+#include <http_client/http_client_resolver.h>
+#include <http_client/http_client_cache.h>
+#include <http_client/url.h>
+
+#include "http_client_scan.h"
+#include "http_client_decode.h"
+
+#if defined( _MSC_VER )
+#  undef UNICODE
+#  include <winsock2.h>
+#  include <ws2tcpip.h>
+#  include <windows.h>
+#
+#  define snprintf _snprintf
+#  define strncasecmp _strnicmp
+#  define poll WSAPoll
+#  define MSG_DONTWAIT 0
+
+	typedef SSIZE_T ssize_t;
+	typedef WSABUF http_client_iovec;
+#else
+#  include <sys/types.h>
+#  include <sys/socket.h>
+#  include <netinet/in.h>
+#  include <arpa/inet.h>
+#  include <unistd.h>
+#  include <netdb.h>
+#  include <poll.h>
+#  include <pthread.h>
+#  include <netinet/tcp.h>
+#  include <sys/uio.h>
+
+	typedef iovec http_client_iovec;
+#endif
+
+#if !defined( MSG_NOSIGNAL )
+#  define MSG_NOSIGNAL 0
+#endif
+
+struct http_client
+{
+	int sockfd;
+	parsed_url* url;
+	const char* useragent;
+
+	sockaddr_storage addr;    ///< address used for the last successful connect, used to reconnect without a new lookup.
+	socklen_t addrlen;        ///< size of addr or 0 if no connection has been made.
+	unsigned int socket_uses; ///< number of requests that has been sent on the current socket.
+
+	char*  recv_buffer;       ///< buffer responses are received and parsed in, allocated together with the client.
+	size_t recv_buffer_size;
+
+	http_client_header headers[HTTP_CLIENT_MAX_HEADERS]; ///< headers of the last response, pointing into recv_buffer.
+	size_t num_headers;
+	unsigned char known_headers[HTTP_CLIENT_HEADER_KNOWN_COUNT]; ///< index + 1 in headers of the first header with each id, 0 if not received.
+
+	http_client_stats stats;  ///< stats of the current or last call.
+	http_client_timeouts timeouts;
+	unsigned long long deadline; ///< time in ms when the current call times out, 0 for none.
+
+	unsigned int decode_encodings; ///< HTTP_CLIENT_ENCODING_*-flags of content-codings to request and decompress.
+	http_decoder* decoder;         ///< created on the first encoded body and reused by later ones.
+	char accept_encoding[64];      ///< Accept-Encoding header sent with each request, empty if decompression is off.
+
+	http_client_cache* cache;      ///< cache used by GETs, NULL if none.
+
+	const http_client_hooks* hooks; ///< never NULL, points to an empty table if no hooks are set.
+	void* hooks_userdata;
+};
+
+/**
+ * Call hook on client with args, args is a parenthesized argument-list ending with client->hooks_userdata.
+ */
+#if defined( HTTP_CLIENT_DISABLE_HOOKS )
+#  define HTTP_CLIENT_HOOK( client, hook, args ) do {} while( 0 )
+#else
+#  define HTTP_CLIENT_HOOK( client, hook, args ) do { if( (client)->hooks->hook ) (client)->hooks->hook args; } while( 0 )
+#endif
+
+/**
+ * Information about a response parsed from status-line and headers.
+ */
+struct http_response
+{
+	unsigned int status;
+	size_t content_length;   ///< value of content-length, only valid if has_content_length is set.
+	bool   has_content_length;
+	bool   chunked;
+	bool   keep_alive;       ///< connection can be used for another request after this response.
+	unsigned int content_encoding; ///< HTTP_CLIENT_ENCODING_*-flag of the body, 0 if not encoded with a supported coding.
+};
+
+/**
+ * Where to put the message body of a response.
+ *
+ * write() is called with each received part of the body. If reserve() is set it is called before each recv()
+ * to get memory to receive directly into, write() will then be called with the same pointer returned by
+ * reserve() and no copy needs to be done.
+ */
+struct http_body_sink
+{
+	http_client_result (*begin)( http_body_sink* self, const http_response* response );
+	http_client_result (*reserve)( http_body_sink* self, size_t size, void** dst, size_t* avail );
+	http_client_result (*write)( http_body_sink* self, const void* data, size_t size );
+};
+
+/**
+ * Connect a new client to the same host as client, with the same user agent, receive buffer size, timeouts and
+ * decompression but without hooks or cache. The address client is connected to is tried first to skip the name
+ * lookup. The url of clone points into client so client needs to outlive it, clone is freed with
+ * http_client_disconnect() and free().
+ */
+http_client_result http_client_clone( http_client_t client, http_client_t* clone );
+
+/**
+ * GET/HEAD resource on client with the extra header block headers, bypassing the response cache. Body of a successful
+ * response is written to sink.
+ */
+http_client_result http_client_request( http_client_t client, const char* verb, const char* resource, const char* headers, http_body_sink* sink, http_response* response );
+
+/**
+ * Return the timeouts set by http_client_set_default_timeouts().
+ */
+const http_client_timeouts* http_client_get_default_timeouts();
+
+/**
+ * Return a monotonic timestamp in milliseconds.
+ */
+unsigned long long http_client_time_ms();
+
+/**
+ * Return a monotonic timestamp in microseconds.
+ */
+unsigned long long http_client_time_us();
+
+/**
+ * Addresses of a host/port as returned by the system resolver, in the order they should be tried.
+ */
+#define HTTP_CLIENT_MAX_ADDRS 8
+
+struct http_client_addr_list
+{
+	unsigned int     count;
+	sockaddr_storage addrs[HTTP_CLIENT_MAX_ADDRS];
+	socklen_t        lens[HTTP_CLIENT_MAX_ADDRS];
+};
+
+/**
+ * Look up host/port with the system resolver, blocking until done.
+ */
+http_client_result http_client_getaddrinfo( const char* host, unsigned int port, http_client_addr_list* addrs );
+
+/**
+ * Return resolver set by http_client_resolver_set_default(), NULL if none.
+ */
+http_client_resolver* http_client_resolver_get_default();
+
+/**
+ * Look up host/port through the cache of resolver, blocking until done. Does a plain lookup if resolver is NULL.
+ */
+http_client_result http_client_resolve( http_client_resolver* resolver, const char* host, unsigned int port, http_client_addr_list* addrs );
+
+/**
+ * Get host/port from the cache of resolver without blocking, returns false if it is not cached or still in flight.
+ * *result is set to the result of the cached lookup and addrs filled if it succeeded.
+ */
+bool http_client_resolver_peek( http_client_resolver* resolver, const char* host, unsigned int port, http_client_addr_list* addrs, http_client_result* result );
+
+/**
+ * Check if a previously used connection is still usable, i.e. the server has not closed it while it was idle.
+ */
+bool http_client_socket_alive( int sockfd );
+
+void  http_client_close_socket( int sockfd );
+
+/**
+ * Disable Nagle on a connected socket, requests are always written in full so there is nothing to gain from
+ * coalescing and it risks stalling on delayed ack.
+ */
+void  http_client_set_nodelay( int sockfd );
+void* http_client_alloc( void* ptr, size_t size, http_client_allocator* alloc );
+
+static inline void http_client_iov_set( http_client_iovec* iov, const void* data, size_t size )
+{
+#if defined( _MSC_VER )
+	iov->buf = (CHAR*)data;
+	iov->len = (ULONG)size;
+#else
+	iov->iov_base = (void*)data;
+	iov->iov_len  = size;
+#endif
+}
+
+static inline size_t http_client_iov_len( const http_client_iovec* iov )
+{
+#if defined( _MSC_VER )
+	return (size_t)iov->len;
+#else
+	return iov->iov_len;
+#endif
+}
+
+static inline char* http_client_iov_base( const http_client_iovec* iov )
+{
+#if defined( _MSC_VER )
+	return (char*)iov->buf;
+#else
+	return (char*)iov->iov_base;
+#endif
+}
+
+/**
+ * Send as much as possible of iov in one syscall, returns bytes sent or -1 on error as send().
+ */
+ssize_t http_client_sendv( int sockfd, const http_client_iovec* iov, int iov_count );
+
+/**
+ * Send all of iov on the connection of client, retrying on partial writes and EINTR and waiting for the socket to be
+ * writable as long as the write timeout and deadline of client allows. iov is modified.
+ */
+http_client_result http_client_sendv_all( http_client_t client, http_client_iovec* iov, int iov_count );
+
+/**
+ * Format request-line and headers for a request to buffer, return value as snprintf().
+ * Content-Length is added unless content_length is HTTP_CLIENT_NO_BODY or HTTP_CLIENT_CHUNKED_BODY, the latter adds
+ * "Transfer-Encoding: chunked".
+ */
+#define HTTP_CLIENT_NO_BODY      ((size_t)-1)
+#define HTTP_CLIENT_CHUNKED_BODY ((size_t)-2)
+
+int http_client_format_request( char* buffer, size_t buffer_size, const char* verb, const char* resource, const char* host, const char* useragent, size_t content_length, const char* headers );
+
+/**
+ * Parse a '\0'-terminated status-line, "HTTP/1.1 200 OK".
+ */
+bool http_client_parse_status_line( const char* line, unsigned int* protocol_major, unsigned int* protocol_minor, unsigned int* status );
+
+/**
+ * Parse the size of a chunk from a '\0'-terminated chunk-size line, "1a2b" or "1a2b;ext=value".
+ */
+size_t http_client_parse_chunk_size( const char* line );
+
+/**
+ * Setup response from a parsed status-line, call http_client_parse_header_line() for each header, or
+ * http_client_parse_header() if the header is already split and classified, and http_client_response_headers_done()
+ * with the verb of the request when all headers are parsed.
+ */
+void http_client_response_init( http_response* response, unsigned int protocol_major, unsigned int protocol_minor, unsigned int status );
+void http_client_parse_header_line( const char* line, http_response* response );
+void http_client_parse_header( http_response* response, http_client_header_id id, const char* value );
+void http_client_response_headers_done( http_response* response, const char* verb );
+
+/**
+ * Return true if a response to verb with status will carry a message body.
+ */
+bool http_client_response_has_body( const char* verb, unsigned int status );
+
+/**
+ * Return true if the comma-separated header value contains token, case-insensitive.
+ */
+bool http_client_header_has_token( const char* value, const char* token );
+
+/**
+ * A response stored in a http_client_cache. Everything but expires is immutable once stored, and the entry is kept
+ * alive by refs while in use even if it is dropped from the cache. Entries of a cache with a disk cache only live for
+ * as long as they are used, wrapping a pinned record.
+ */
+struct http_cache_entry
+{
+	http_cache_entry* hash_next;
+	http_cache_entry* lru_prev;
+	http_cache_entry* lru_next;
+	unsigned int hash;
+	unsigned int refs;           ///< cache itself and lookups using the entry, freed when it reaches 0.
+	unsigned long long expires;  ///< time in ms the response is fresh until.
+
+	const char* key;
+	const char* etag;            ///< value of ETag, NULL if not sent.
+	const char* last_modified;   ///< value of Last-Modified, NULL if not sent.
+	const char* headers;         ///< stored response headers as num_headers pairs of '\0'-terminated name and value.
+	size_t headers_size;
+	size_t num_headers;
+	void*  body;
+	size_t body_size;
+	size_t size;                 ///< bytes accounted for the entry in the cache.
+
+	bool mapped;                 ///< entry is a record of the disk cache, key, headers and body point into its mapping.
+	unsigned long long disk_offset; ///< offset of the record in the disk cache, only valid if mapped.
+};
+
+/**
+ * Find the response to a GET of resource on the host of client. Returns the entry with a reference that needs to be
+ * released with http_client_cache_release() or NULL if not cached. *fresh is set if the entry can be used without
+ * revalidation.
+ */
+http_cache_entry* http_client_cache_lookup( http_client_cache* cache, http_client_t client, const char* resource, bool* fresh );
+void http_client_cache_release( http_client_cache* cache, http_cache_entry* entry );
+
+/**
+ * Check if the response currently received by client may be stored, from its headers. *lifetime is set to the number
+ * of ms it is fresh, 0 if it needs revalidation on each use, and *max_size to the largest body that will be stored.
+ */
+bool http_client_cache_policy( http_client_t client, const http_response* response, unsigned long long* lifetime, size_t* max_size );
+
+/**
+ * Store the response currently received by client to a GET of resource, replacing any earlier response. body must
+ * be allocated with malloc() and is owned by the cache after the call, also on failure. If decoded is set body is
+ * stored decompressed and the Content-Encoding and Content-Length of the response are dropped.
+ */
+void http_client_cache_store( http_client_cache* cache, http_client_t client, const char* resource, unsigned long long lifetime, void* body, size_t body_size, bool decoded );
+
+/**
+ * Mark entry as fresh for another lifetime ms after a successful revalidation.
+ */
+void http_client_cache_refresh( http_client_cache* cache, http_cache_entry* entry, unsigned long long lifetime );
+
+/**
+ * Drop the response to resource on the host of client, if cached.
+ */
+void http_client_cache_invalidate( http_client_cache* cache, http_client_t client, const char* resource );
+
+/**
+ * Make the headers of entry the response headers of client, as returned by http_client_get_header() and friends.
+ */
+void http_client_cache_restore_headers( http_client_t client, const http_cache_entry* entry );
+
+#if defined( _MSC_VER )
+	typedef CRITICAL_SECTION http_client_mutex;
+	static inline void http_client_mutex_init( http_client_mutex* m )    { InitializeCriticalSection( m ); }
+	static inline void http_client_mutex_destroy( http_client_mutex* m ) { DeleteCriticalSection( m ); }
+	static inline void http_client_mutex_lock( http_client_mutex* m )    { EnterCriticalSection( m ); }
+	static inline void http_client_mutex_unlock( http_client_mutex* m )  { LeaveCriticalSection( m ); }
+
+	typedef CONDITION_VARIABLE http_client_cond;
+	static inline void http_client_cond_init( http_client_cond* c )                         { InitializeConditionVariable( c ); }
+	static inline void http_client_cond_destroy( http_client_cond* )                        { }
+	static inline void http_client_cond_wait( http_client_cond* c, http_client_mutex* m )   { SleepConditionVariableCS( c, m, INFINITE ); }
+	static inline void http_client_cond_broadcast( http_client_cond* c )                    { WakeAllConditionVariable( c ); }
+#else
+	typedef pthread_mutex_t http_client_mutex;
+	static inline void http_client_mutex_init( http_client_mutex* m )    { pthread_mutex_init( m, 0x0 ); }
+	static inline void http_client_mutex_destroy( http_client_mutex* m ) { pthread_mutex_destroy( m ); }
+	static inline void http_client_mutex_lock( http_client_mutex* m )    { pthread_mutex_lock( m ); }
+	static inline void http_client_mutex_unlock( http_client_mutex* m )  { pthread_mutex_unlock( m ); }
+
+	typedef pthread_cond_t http_client_cond;
+	static inline void http_client_cond_init( http_client_cond* c )                         { pthread_cond_init( c, 0x0 ); }
+	static inline void http_client_cond_destroy( http_client_cond* c )                      { pthread_cond_destroy( c ); }
+	static inline void http_client_cond_wait( http_client_cond* c, http_client_mutex* m )   { pthread_cond_wait( c, m ); }
+	static inline void http_client_cond_broadcast( http_client_cond* c )                    { pthread_cond_broadcast( c ); }
+#endif
+
+#endif // HTTP_CLIENT_INTERNAL_H_INCLUDED
@@ -0,0 +1,927 @@
+/*
+    Simple http-client written to be an drop-in code, focus is to be small
+    and easy to use but maybe not efficient.
+
+    version 1.0, June, 2014
+
+	Copyright (C) 2014- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+#define URL_PARSER_IMPLEMENTATION_STATIC
+
+#include <http_client/http_client_multi.h>
+#include "http_client_internal.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined( __linux__ )
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+enum http_multi_conn_state
+{
+	HTTP_MULTI_CONNECTING,
+	HTTP_MULTI_SENDING,
+	HTTP_MULTI_RECEIVING,
+	HTTP_MULTI_IDLE
+};
+
+enum http_multi_parse_state
+{
+	HTTP_MULTI_PARSE_STATUS,
+	HTTP_MULTI_PARSE_HEADERS,
+	HTTP_MULTI_PARSE_BODY,
+	HTTP_MULTI_PARSE_BODY_EOF,
+	HTTP_MULTI_PARSE_CHUNK_SIZE,
+	HTTP_MULTI_PARSE_CHUNK_DATA,
+	HTTP_MULTI_PARSE_CHUNK_END,
+	HTTP_MULTI_PARSE_TRAILERS,
+	HTTP_MULTI_PARSE_DONE
+};
+
+struct http_multi_request
+{
+	http_multi_request* next;
+
+	const char* key;       ///< scheme://host:port, used to find a connection to reuse.
+	const char* host;
+	unsigned int port;
+	const char* verb;
+	const char* head;      ///< formatted request-line and headers.
+	size_t head_size;
+	const void* payload;
+	size_t payload_size;
+
+	http_client_multi_callback callback;
+	void* userdata;
+	bool retried;          ///< request has already been retried once after failing on a reused connection.
+	unsigned long long connect_deadline; ///< time in ms when looking up host and connecting times out, 0 if not started or no limit.
+	unsigned long long deadline;         ///< time in ms when the request times out, 0 for no limit.
+};
+
+struct http_multi_conn
+{
+	http_multi_conn* next;
+
+	int fd;
+	char key[320];
+	http_multi_conn_state state;
+	http_client_addr_list addrs; ///< addresses of host, tried in order until one connects.
+	unsigned int next_addr;
+	unsigned int uses;
+
+	http_multi_request* req;
+	size_t sent;           ///< bytes of head + payload sent.
+	unsigned long long progress; ///< time in ms of the last progress on the connection, read/write timeouts count from here.
+
+	http_multi_parse_state parse;
+	char   line[4096];
+	size_t line_len;
+	bool   got_bytes;      ///< any bytes of the response has been received.
+	size_t remaining;      ///< bytes left of body or current chunk.
+	http_response response;
+
+	void*  body;
+	size_t body_size;
+	size_t body_cap;
+};
+
+struct http_client_multi
+{
+	int epfd;
+	int wakefd;            ///< eventfd signaled by the resolver when a lookup is done, -1 if no resolver is used.
+	http_client_multi_config config;
+	http_client_timeouts timeouts;
+
+	http_multi_request* pending_head;
+	http_multi_request* pending_tail;
+	http_multi_conn* conns;
+	unsigned int active;   ///< requests queued or in progress.
+};
+
+static void http_multi_push_pending( http_client_multi_t multi, http_multi_request* req, bool front )
+{
+	req->next = 0x0;
+	if( multi->pending_head == 0x0 )
+	{
+		multi->pending_head = multi->pending_tail = req;
+	}
+	else if( front )
+	{
+		req->next = multi->pending_head;
+		multi->pending_head = req;
+	}
+	else
+	{
+		multi->pending_tail->next = req;
+		multi->pending_tail = req;
+	}
+}
+
+static void http_multi_complete( http_client_multi_t multi, http_multi_request* req, http_client_result result, const void* body, size_t body_size )
+{
+	--multi->active;
+	req->callback( result, body, body_size, req->userdata );
+	free( req );
+}
+
+static void http_multi_watch( http_client_multi_t multi, http_multi_conn* conn, int op )
+{
+	epoll_event ev;
+	memset( &ev, 0x0, sizeof( ev ) );
+	ev.events   = conn->state == HTTP_MULTI_CONNECTING || conn->state == HTTP_MULTI_SENDING ? EPOLLOUT : EPOLLIN;
+	ev.data.ptr = conn;
+	epoll_ctl( multi->epfd, op, conn->fd, &ev );
+}
+
+static void http_multi_set_state( http_client_multi_t multi, http_multi_conn* conn, http_multi_conn_state state )
+{
+	bool was_out = conn->state == HTTP_MULTI_CONNECTING || conn->state == HTTP_MULTI_SENDING;
+	bool is_out  = state == HTTP_MULTI_CONNECTING || state == HTTP_MULTI_SENDING;
+	conn->state = state;
+	conn->progress = http_client_time_ms();
+	if( was_out != is_out )
+		http_multi_watch( multi, conn, EPOLL_CTL_MOD );
+}
+
+static void http_multi_close_conn( http_client_multi_t multi, http_multi_conn* conn )
+{
+	for( http_multi_conn** it = &multi->conns; *it; it = &(*it)->next )
+	{
+		if( *it == conn )
+		{
+			*it = conn->next;
+			break;
+		}
+	}
+
+	if( conn->fd >= 0 )
+	{
+		epoll_ctl( multi->epfd, EPOLL_CTL_DEL, conn->fd, 0x0 );
+		http_client_close_socket( conn->fd );
+	}
+	if( conn->body )
+		http_client_alloc( conn->body, 0, multi->config.alloc );
+	free( conn );
+}
+
+/**
+ * Fail request on conn and close the connection. If the connection was reused and no bytes of the response was received
+ * the server might just have closed an idle connection, the request is then retried once on a new connection.
+ */
+static void http_multi_fail_conn( http_client_multi_t multi, http_multi_conn* conn, http_client_result result )
+{
+	http_multi_request* req = conn->req;
+	bool retry = req != 0x0 && conn->uses > 1 && !conn->got_bytes && !req->retried;
+	conn->req = 0x0;
+	http_multi_close_conn( multi, conn );
+
+	if( req == 0x0 )
+		return;
+
+	if( retry )
+	{
+		req->retried = true;
+		req->connect_deadline = 0;
+		http_multi_push_pending( multi, req, true );
+	}
+	else
+		http_multi_complete( multi, req, result, 0x0, 0 );
+}
+
+static void http_multi_start_request( http_client_multi_t multi, http_multi_conn* conn, http_multi_request* req )
+{
+	conn->req       = req;
+	conn->sent      = 0;
+	conn->parse     = HTTP_MULTI_PARSE_STATUS;
+	conn->line_len  = 0;
+	conn->got_bytes = false;
+	conn->remaining = 0;
+	conn->body_size = 0;
+	++conn->uses;
+
+	if( conn->state == HTTP_MULTI_IDLE )
+		http_multi_set_state( multi, conn, HTTP_MULTI_SENDING );
+}
+
+/**
+ * Start a non-blocking connect of conn to the next of its addresses that does not fail directly.
+ */
+static bool http_multi_open( http_multi_conn* conn )
+{
+	while( conn->next_addr < conn->addrs.count )
+	{
+		unsigned int addr = conn->next_addr++;
+		int fd = socket( conn->addrs.addrs[addr].ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+		if( fd < 0 )
+			continue;
+
+		if( connect( fd, (const sockaddr*)&conn->addrs.addrs[addr], conn->addrs.lens[addr] ) < 0 && errno != EINPROGRESS )
+		{
+			http_client_close_socket( fd );
+			continue;
+		}
+
+		conn->fd = fd;
+		return true;
+	}
+	return false;
+}
+
+static http_multi_conn* http_multi_connect( http_client_multi_t multi, http_multi_request* req, const http_client_addr_list* addrs )
+{
+	http_multi_conn* conn = (http_multi_conn*)malloc( sizeof( http_multi_conn ) );
+	if( conn == 0x0 )
+		return 0x0;
+
+	memset( conn, 0x0, sizeof( http_multi_conn ) );
+	conn->addrs = *addrs;
+	if( !http_multi_open( conn ) )
+	{
+		free( conn );
+		return 0x0;
+	}
+
+	conn->state = HTTP_MULTI_CONNECTING;
+	conn->progress = http_client_time_ms();
+	strcpy( conn->key, req->key );
+	conn->next  = multi->conns;
+	multi->conns = conn;
+	http_multi_watch( multi, conn, EPOLL_CTL_ADD );
+	return conn;
+}
+
+/**
+ * Called by the resolver, possibly from a resolver thread, when a lookup started by http_multi_resolve() is done.
+ */
+static void http_multi_wake( http_client_result, void* userdata )
+{
+	http_client_multi_t multi = (http_client_multi_t)userdata;
+	uint64_t one = 1;
+	ssize_t res = write( multi->wakefd, &one, sizeof( one ) );
+	(void)res;
+}
+
+/**
+ * Get addresses to connect to for req. Returns false if the lookup is still in flight, multi is then woken up when it
+ * is done and the request should be dispatched again.
+ */
+static bool http_multi_resolve( http_client_multi_t multi, http_multi_request* req, http_client_addr_list* addrs, http_client_result* result )
+{
+	if( multi->config.resolver == 0x0 )
+	{
+		*result = http_client_getaddrinfo( req->host, req->port, addrs );
+		return true;
+	}
+
+	if( http_client_resolver_peek( multi->config.resolver, req->host, req->port, addrs, result ) )
+		return true;
+
+	*result = http_client_resolver_resolve_async( multi->config.resolver, req->host, req->port, http_multi_wake, multi );
+	return *result != HTTP_CLIENT_OK;
+}
+
+/**
+ * Return the earliest of the request-timeout and connect-timeout of a queued request, 0 if it has none.
+ */
+static unsigned long long http_multi_request_expires( const http_multi_request* req )
+{
+	if( req->connect_deadline != 0 && ( req->deadline == 0 || req->connect_deadline < req->deadline ) )
+		return req->connect_deadline;
+	return req->deadline;
+}
+
+/**
+ * Return the time when the phase conn is in times out, 0 if it has no timeout. *result is set to the error to
+ * complete the request with.
+ */
+static unsigned long long http_multi_conn_expires( http_client_multi_t multi, const http_multi_conn* conn, http_client_result* result )
+{
+	if( conn->req == 0x0 )
+		return 0; // ... idle connections are closed by the server when it sees fit ...
+
+	unsigned long long expires = 0;
+	switch( conn->state )
+	{
+		case HTTP_MULTI_CONNECTING:
+			*result = HTTP_CLIENT_CONNECT_TIMEOUT;
+			expires = conn->req->connect_deadline;
+			break;
+		case HTTP_MULTI_SENDING:
+			*result = HTTP_CLIENT_WRITE_TIMEOUT;
+			expires = multi->timeouts.write ? conn->progress + multi->timeouts.write : 0;
+			break;
+		default:
+			*result = HTTP_CLIENT_READ_TIMEOUT;
+			expires = multi->timeouts.read ? conn->progress + multi->timeouts.read : 0;
+			break;
+	}
+	if( conn->req->deadline != 0 && ( expires == 0 || conn->req->deadline < expires ) )
+		expires = conn->req->deadline;
+	return expires;
+}
+
+/**
+ * Fail requests on connections that has timed out. Queued requests are timed out by http_multi_dispatch().
+ */
+static void http_multi_expire( http_client_multi_t multi, unsigned long long now )
+{
+	http_multi_conn* conn = multi->conns;
+	while( conn )
+	{
+		http_multi_conn* next = conn->next;
+		http_client_result result;
+		unsigned long long expires = http_multi_conn_expires( multi, conn, &result );
+		if( expires != 0 && now >= expires )
+		{
+			conn->req->retried = true; // ... a slow server is not a closed keep-alive connection, do not retry ...
+			http_multi_fail_conn( multi, conn, result );
+		}
+		conn = next;
+	}
+}
+
+/**
+ * Return time in ms until the next request times out, or -1 if there is no timeout.
+ */
+static int http_multi_next_timeout( http_client_multi_t multi, unsigned long long now )
+{
+	unsigned long long next = 0;
+	for( http_multi_request* req = multi->pending_head; req; req = req->next )
+	{
+		unsigned long long expires = http_multi_request_expires( req );
+		if( expires != 0 && ( next == 0 || expires < next ) )
+			next = expires;
+	}
+	for( http_multi_conn* conn = multi->conns; conn; conn = conn->next )
+	{
+		http_client_result result;
+		unsigned long long expires = http_multi_conn_expires( multi, conn, &result );
+		if( expires != 0 && ( next == 0 || expires < next ) )
+			next = expires;
+	}
+
+	if( next == 0 )
+		return -1;
+	if( next <= now )
+		return 0;
+	return next - now > 0x7fffffff ? 0x7fffffff : (int)( next - now );
+}
+
+/**
+ * Assign queued requests to idle connections or new connections as long as max_per_host allows it. Queued requests
+ * that has timed out are completed.
+ */
+static void http_multi_dispatch( http_client_multi_t multi )
+{
+	// ... detach queue, callbacks of failed requests might add new requests while dispatching ...
+	http_multi_request* queue = multi->pending_head;
+	multi->pending_head = multi->pending_tail = 0x0;
+
+	http_multi_request* waiting_head = 0x0;
+	http_multi_request* waiting_tail = 0x0;
+	unsigned long long now = http_client_time_ms();
+	while( queue )
+	{
+		http_multi_request* req = queue;
+		queue = req->next;
+		req->next = 0x0;
+
+		unsigned long long expires = http_multi_request_expires( req );
+		if( expires != 0 && now >= expires )
+		{
+			// ... never got a connection, the request-timeout too is reported as failing to connect ...
+			http_multi_complete( multi, req, HTTP_CLIENT_CONNECT_TIMEOUT, 0x0, 0 );
+			continue;
+		}
+
+		http_multi_conn* idle = 0x0;
+		unsigned int host_conns = 0;
+		for( http_multi_conn* conn = multi->conns; conn; conn = conn->next )
+		{
+			if( strcmp( conn->key, req->key ) != 0 )
+				continue;
+			++host_conns;
+			if( conn->state == HTTP_MULTI_IDLE )
+				idle = conn;
+		}
+
+		http_multi_conn* conn = idle;
+		if( conn == 0x0 && ( multi->config.max_per_host == 0 || host_conns < multi->config.max_per_host ) )
+		{
+			if( req->connect_deadline == 0 && multi->timeouts.connect != 0 )
+				req->connect_deadline = now + multi->timeouts.connect;
+
+			http_client_addr_list addrs;
+			http_client_result res;
+			if( http_multi_resolve( multi, req, &addrs, &res ) )
+			{
+				if( res == HTTP_CLIENT_OK )
+					conn = http_multi_connect( multi, req, &addrs );
+				if( conn == 0x0 )
+				{
+					http_multi_complete( multi, req, res == HTTP_CLIENT_OK ? HTTP_CLIENT_SOCKET_ERROR : res, 0x0, 0 );
+					continue;
+				}
+			}
+		}
+
+		if( conn != 0x0 )
+		{
+			http_multi_start_request( multi, conn, req );
+			continue;
+		}
+
+		if( waiting_tail )
+			waiting_tail->next = req;
+		else
+			waiting_head = req;
+		waiting_tail = req;
+	}
+
+	// ... requests still waiting for a connection goes before requests added during dispatch ...
+	if( waiting_head )
+	{
+		waiting_tail->next = multi->pending_head;
+		if( multi->pending_tail == 0x0 )
+			multi->pending_tail = waiting_tail;
+		multi->pending_head = waiting_head;
+	}
+}
+
+static bool http_multi_body_append( http_client_multi_t multi, http_multi_conn* conn, const char* data, size_t size )
+{
+	if( conn->body_size + size > conn->body_cap )
+	{
+		size_t new_cap = conn->body_cap < 4096 ? 4096 : conn->body_cap * 2;
+		while( new_cap < conn->body_size + size )
+			new_cap *= 2;
+		void* mem = http_client_alloc( conn->body, new_cap, multi->config.alloc );
+		if( mem == 0x0 )
+			return false;
+		conn->body = mem;
+		conn->body_cap = new_cap;
+	}
+	memcpy( (char*)conn->body + conn->body_size, data, size );
+	conn->body_size += size;
+	return true;
+}
+
+static http_client_result http_multi_parse_line( http_multi_conn* conn, const char* line )
+{
+	switch( conn->parse )
+	{
+		case HTTP_MULTI_PARSE_STATUS:
+		{
+			unsigned int protocol_major, protocol_minor, status;
+			if( !http_client_parse_status_line( line, &protocol_major, &protocol_minor, &status ) )
+				return HTTP_CLIENT_SOCKET_ERROR;
+			http_client_response_init( &conn->response, protocol_major, protocol_minor, status );
+			conn->parse = HTTP_MULTI_PARSE_HEADERS;
+			break;
+		}
+		case HTTP_MULTI_PARSE_HEADERS:
+		{
+			if( line[0] != '\0' )
+			{
+				http_client_parse_header_line( line, &conn->response );
+				break;
+			}
+
+			http_response* response = &conn->response;
+			http_client_response_headers_done( response, conn->req->verb );
+			if( response->status >= 100 && response->status < 200 )
+				conn->parse = HTTP_MULTI_PARSE_STATUS; // ... skip informational 1xx responses ...
+			else if( !http_client_response_has_body( conn->req->verb, response->status ) )
+				conn->parse = HTTP_MULTI_PARSE_DONE;
+			else if( response->chunked )
+				conn->parse = HTTP_MULTI_PARSE_CHUNK_SIZE;
+			else if( response->has_content_length )
+			{
+				conn->remaining = response->content_length;
+				conn->parse = conn->remaining == 0 ? HTTP_MULTI_PARSE_DONE : HTTP_MULTI_PARSE_BODY;
+			}
+			else
+				conn->parse = HTTP_MULTI_PARSE_BODY_EOF;
+			break;
+		}
+		case HTTP_MULTI_PARSE_CHUNK_SIZE:
+			if( line[0] == '\0' )
+				break;
+			conn->remaining = http_client_parse_chunk_size( line );
+			conn->parse = conn->remaining == 0 ? HTTP_MULTI_PARSE_TRAILERS : HTTP_MULTI_PARSE_CHUNK_DATA;
+			break;
+		case HTTP_MULTI_PARSE_CHUNK_END:
+			conn->parse = HTTP_MULTI_PARSE_CHUNK_SIZE;
+			break;
+		case HTTP_MULTI_PARSE_TRAILERS:
+			if( line[0] == '\0' )
+				conn->parse = HTTP_MULTI_PARSE_DONE;
+			break;
+		default:
+			return HTTP_CLIENT_INTERNAL_ERROR;
+	}
+	return HTTP_CLIENT_OK;
+}
+
+/**
+ * Feed received bytes to the response parser of conn, returns number of bytes consumed in *consumed.
+ */
+static http_client_result http_multi_parse( http_client_multi_t multi, http_multi_conn* conn, const char* data, size_t size, size_t* consumed )
+{
+	const char* start = data;
+	while( size > 0 && conn->parse != HTTP_MULTI_PARSE_DONE )
+	{
+		switch( conn->parse )
+		{
+			case HTTP_MULTI_PARSE_BODY:
+			case HTTP_MULTI_PARSE_CHUNK_DATA:
+			case HTTP_MULTI_PARSE_BODY_EOF:
+			{
+				size_t take = size;
+				if( conn->parse != HTTP_MULTI_PARSE_BODY_EOF && take > conn->remaining )
+					take = conn->remaining;
+				if( !http_multi_body_append( multi, conn, data, take ) )
+					return HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+				data += take;
+				size -= take;
+
+				if( conn->parse == HTTP_MULTI_PARSE_BODY_EOF )
+					break;
+				conn->remaining -= take;
+				if( conn->remaining == 0 )
+					conn->parse = conn->parse == HTTP_MULTI_PARSE_BODY ? HTTP_MULTI_PARSE_DONE : HTTP_MULTI_PARSE_CHUNK_END;
+				break;
+			}
+			default:
+			{
+				const char* nl = (const char*)memchr( data, '\n', size );
+				size_t take = nl ? (size_t)( nl - data + 1 ) : size;
+				if( conn->line_len + take >= sizeof( conn->line ) )
+					return HTTP_CLIENT_INTERNAL_ERROR; // ... line do not fit in buffer ...
+				memcpy( conn->line + conn->line_len, data, take );
+				conn->line_len += take;
+				data += take;
+				size -= take;
+				if( nl == 0x0 )
+					break;
+
+				size_t len = conn->line_len - 1;
+				if( len > 0 && conn->line[len - 1] == '\r' )
+					--len;
+				conn->line[len] = '\0';
+				conn->line_len = 0;
+
+				http_client_result res = http_multi_parse_line( conn, conn->line );
+				if( res != HTTP_CLIENT_OK )
+					return res;
+				break;
+			}
+		}
+	}
+	*consumed = (size_t)( data - start );
+	return HTTP_CLIENT_OK;
+}
+
+static void http_multi_finish_response( http_client_multi_t multi, http_multi_conn* conn, bool reusable )
+{
+	http_multi_request* req = conn->req;
+	conn->req = 0x0;
+
+	unsigned int status = conn->response.status;
+	bool keep = reusable && conn->response.keep_alive;
+	if( keep )
+		http_multi_set_state( multi, conn, HTTP_MULTI_IDLE );
+
+	// ... connection is closed after the callback since the body is owned by it ...
+	http_multi_complete( multi, req, status < 300 ? HTTP_CLIENT_OK : (http_client_result)status, conn->body, conn->body_size );
+	conn->body_size = 0;
+
+	if( !keep )
+		http_multi_close_conn( multi, conn );
+}
+
+static void http_multi_on_send( http_client_multi_t multi, http_multi_conn* conn )
+{
+	http_multi_request* req = conn->req;
+	while( conn->sent < req->head_size + req->payload_size )
+	{
+		// ... what is left of head and payload in one syscall ...
+		http_client_iovec iov[2];
+		int iov_count = 0;
+		if( conn->sent < req->head_size )
+			http_client_iov_set( &iov[iov_count++], req->head + conn->sent, req->head_size - conn->sent );
+		size_t payload_sent = conn->sent > req->head_size ? conn->sent - req->head_size : 0;
+		if( payload_sent < req->payload_size )
+			http_client_iov_set( &iov[iov_count++], (const char*)req->payload + payload_sent, req->payload_size - payload_sent );
+
+		ssize_t res = http_client_sendv( conn->fd, iov, iov_count );
+		if( res < 0 )
+		{
+			if( errno == EINTR )
+				continue;
+			if( errno == EAGAIN || errno == EWOULDBLOCK )
+				return;
+			http_multi_fail_conn( multi, conn, HTTP_CLIENT_SOCKET_ERROR );
+			return;
+		}
+		conn->sent += (size_t)res;
+		conn->progress = http_client_time_ms();
+	}
+
+	http_multi_set_state( multi, conn, HTTP_MULTI_RECEIVING );
+}
+
+static void http_multi_on_recv( http_client_multi_t multi, http_multi_conn* conn )
+{
+	char buffer[16 * 1024];
+	while( true )
+	{
+		ssize_t res = recv( conn->fd, buffer, sizeof( buffer ), 0 );
+		if( res < 0 )
+		{
+			if( errno == EINTR )
+				continue;
+			if( errno == EAGAIN || errno == EWOULDBLOCK )
+				return;
+			http_multi_fail_conn( multi, conn, HTTP_CLIENT_SOCKET_ERROR );
+			return;
+		}
+
+		if( conn->state == HTTP_MULTI_IDLE )
+		{
+			// ... EOF or unexpected data on an idle connection, either way it can't be used ...
+			http_multi_close_conn( multi, conn );
+			return;
+		}
+
+		if( res == 0 )
+		{
+			if( conn->parse == HTTP_MULTI_PARSE_BODY_EOF )
+				http_multi_finish_response( multi, conn, false );
+			else
+				http_multi_fail_conn( multi, conn, HTTP_CLIENT_CONNECTION_LOST );
+			return;
+		}
+
+		conn->got_bytes = true;
+		conn->progress = http_client_time_ms();
+		size_t consumed = 0;
+		http_client_result err = http_multi_parse( multi, conn, buffer, (size_t)res, &consumed );
+		if( err != HTTP_CLIENT_OK )
+		{
+			http_multi_fail_conn( multi, conn, err );
+			return;
+		}
+
+		if( conn->parse == HTTP_MULTI_PARSE_DONE )
+		{
+			// ... anything left belongs to no request we made, can't reuse the connection ...
+			http_multi_finish_response( multi, conn, consumed == (size_t)res );
+			return;
+		}
+	}
+}
+
+static void http_multi_on_event( http_client_multi_t multi, http_multi_conn* conn, unsigned int events )
+{
+	switch( conn->state )
+	{
+		case HTTP_MULTI_CONNECTING:
+		{
+			int err = 0;
+			socklen_t len = sizeof( err );
+			if( getsockopt( conn->fd, SOL_SOCKET, SO_ERROR, &err, &len ) < 0 || err != 0 )
+			{
+				// ... try the next address, if any, on a new socket ...
+				epoll_ctl( multi->epfd, EPOLL_CTL_DEL, conn->fd, 0x0 );
+				http_client_close_socket( conn->fd );
+				if( http_multi_open( conn ) )
+				{
+					http_multi_watch( multi, conn, EPOLL_CTL_ADD );
+					return;
+				}
+				conn->fd = -1;
+				http_multi_fail_conn( multi, conn, HTTP_CLIENT_SOCKET_ERROR );
+				return;
+			}
+			http_client_set_nodelay( conn->fd );
+			conn->state = HTTP_MULTI_SENDING;
+			conn->progress = http_client_time_ms();
+			http_multi_on_send( multi, conn );
+			break;
+		}
+		case HTTP_MULTI_SENDING:
+			if( events & ( EPOLLERR | EPOLLHUP ) )
+				http_multi_fail_conn( multi, conn, HTTP_CLIENT_SOCKET_ERROR );
+			else
+				http_multi_on_send( multi, conn );
+			break;
+		case HTTP_MULTI_RECEIVING:
+		case HTTP_MULTI_IDLE:
+			http_multi_on_recv( multi, conn );
+			break;
+	}
+}
+
+http_client_result http_client_multi_create( http_client_multi_t* multi, const http_client_multi_config* config )
+{
+	http_client_multi* m = (http_client_multi*)malloc( sizeof( http_client_multi ) );
+	if( m == 0x0 )
+		return HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+
+	memset( m, 0x0, sizeof( http_client_multi ) );
+	if( config )
+		m->config = *config;
+	if( m->config.useragent == 0x0 )
+		m->config.useragent = "http-client";
+
+	if( m->config.resolver == 0x0 )
+		m->config.resolver = http_client_resolver_get_default();
+
+	m->timeouts = m->config.timeouts ? *m->config.timeouts : *http_client_get_default_timeouts();
+	m->config.timeouts = 0x0; // ... copied, do not keep a pointer to the callers struct ...
+
+	m->wakefd = -1;
+	m->epfd = epoll_create1( EPOLL_CLOEXEC );
+	if( m->epfd < 0 )
+	{
+		free( m );
+		return HTTP_CLIENT_SOCKET_ERROR;
+	}
+
+	if( m->config.resolver != 0x0 )
+	{
+		// ... the wake-up fd is registered with a NULL ptr to tell it apart from connections ...
+		epoll_event ev;
+		memset( &ev, 0x0, sizeof( ev ) );
+		ev.events = EPOLLIN;
+		m->wakefd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+		if( m->wakefd < 0 || epoll_ctl( m->epfd, EPOLL_CTL_ADD, m->wakefd, &ev ) < 0 )
+		{
+			if( m->wakefd >= 0 )
+				http_client_close_socket( m->wakefd );
+			http_client_close_socket( m->epfd );
+			free( m );
+			return HTTP_CLIENT_SOCKET_ERROR;
+		}
+	}
+
+	*multi = m;
+	return HTTP_CLIENT_OK;
+}
+
+void http_client_multi_destroy( http_client_multi_t multi )
+{
+	if( multi->config.resolver )
+		http_client_resolver_cancel( multi->config.resolver, http_multi_wake, multi );
+
+	while( multi->conns )
+		http_multi_fail_conn( multi, multi->conns, HTTP_CLIENT_CONNECTION_LOST );
+
+	while( multi->pending_head )
+	{
+		http_multi_request* req = multi->pending_head;
+		multi->pending_head = req->next;
+		http_multi_complete( multi, req, HTTP_CLIENT_CONNECTION_LOST, 0x0, 0 );
+	}
+
+	if( multi->wakefd >= 0 )
+		http_client_close_socket( multi->wakefd );
+	http_client_close_socket( multi->epfd );
+	free( multi );
+}
+
+http_client_result http_client_multi_add( http_client_multi_t multi,
+										  const char* verb,
+										  const char* url,
+										  const char* resource,
+										  const void* payload,
+										  size_t payload_size,
+										  http_client_multi_callback callback,
+										  void* userdata )
+{
+	parsed_url* parsed = parse_url( url, 0x0, 0 );
+	if( parsed == 0x0 )
+		return HTTP_CLIENT_INVALID_URL;
+	if( parsed->scheme != 0x0 && strcmp( parsed->scheme, "http" ) != 0 )
+	{
+		free( parsed );
+		return HTTP_CLIENT_UNSUPPORTED_SCHEME;
+	}
+
+	unsigned int port = parsed->port == 0 ? 80 : parsed->port;
+	char key[320];
+	int key_len  = snprintf( key, sizeof( key ), "http://%s:%u", parsed->host, port );
+	int head_len = http_client_format_request( 0x0, 0, verb, resource, parsed->host, multi->config.useragent, payload ? payload_size : HTTP_CLIENT_NO_BODY, 0x0 );
+	if( key_len < 0 || (size_t)key_len >= sizeof( key ) || head_len < 0 )
+	{
+		free( parsed );
+		return HTTP_CLIENT_INVALID_URL;
+	}
+
+	// ... request, key, host, verb and head in one allocation ...
+	size_t host_len = strlen( parsed->host );
+	size_t verb_len = strlen( verb );
+	size_t size = sizeof( http_multi_request ) + (size_t)key_len + 1 + host_len + 1 + verb_len + 1 + (size_t)head_len + 1;
+	http_multi_request* req = (http_multi_request*)malloc( size );
+	if( req == 0x0 )
+	{
+		free( parsed );
+		return HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+	}
+
+	char* str = (char*)( req + 1 );
+	memset( req, 0x0, sizeof( http_multi_request ) );
+	req->key  = strcpy( str, key );                        str += key_len + 1;
+	req->host = strcpy( str, parsed->host );               str += host_len + 1;
+	req->verb = strcpy( str, verb );                       str += verb_len + 1;
+	http_client_format_request( str, (size_t)head_len + 1, verb, resource, parsed->host, multi->config.useragent, payload ? payload_size : HTTP_CLIENT_NO_BODY, 0x0 );
+	req->head         = str;
+	req->head_size    = (size_t)head_len;
+	req->port         = port;
+	req->payload      = payload;
+	req->payload_size = payload == 0x0 ? 0 : payload_size;
+	req->callback     = callback;
+	req->userdata     = userdata;
+	req->deadline     = multi->timeouts.request ? http_client_time_ms() + multi->timeouts.request : 0;
+	free( parsed );
+
+	http_multi_push_pending( multi, req, false );
+	++multi->active;
+	return HTTP_CLIENT_OK;
+}
+
+unsigned int http_client_multi_run( http_client_multi_t multi, int timeout )
+{
+	http_multi_dispatch( multi );
+	if( multi->active == 0 )
+		return 0;
+
+	int next_timeout = http_multi_next_timeout( multi, http_client_time_ms() );
+	if( next_timeout >= 0 && ( timeout < 0 || next_timeout < timeout ) )
+		timeout = next_timeout;
+
+	epoll_event events[64];
+	int num_events = epoll_wait( multi->epfd, events, 64, timeout );
+	for( int i = 0; i < num_events; ++i )
+	{
+		if( events[i].data.ptr == 0x0 )
+		{
+			// ... lookup done, requests waiting for it are picked up by the dispatch below ...
+			uint64_t count;
+			ssize_t res = read( multi->wakefd, &count, sizeof( count ) );
+			(void)res;
+			continue;
+		}
+		http_multi_on_event( multi, (http_multi_conn*)events[i].data.ptr, events[i].events );
+	}
+
+	http_multi_expire( multi, http_client_time_ms() );
+	http_multi_dispatch( multi );
+	return multi->active;
+}
+
+#else
+
+http_client_result http_client_multi_create( http_client_multi_t* multi, const http_client_multi_config* )
+{
+	*multi = 0x0;
+	return HTTP_CLIENT_NOT_SUPPORTED;
+}
+
+void http_client_multi_destroy( http_client_multi_t ) {}
+
+http_client_result http_client_multi_add( http_client_multi_t, const char*, const char*, const char*, const void*, size_t, http_client_multi_callback, void* )
+{
+	return HTTP_CLIENT_NOT_SUPPORTED;
+}
+
+unsigned int http_client_multi_run( http_client_multi_t, int )
+{
+	return 0;
+}
+
+#endif // defined( __linux__ )
@@ -0,0 +1,293 @@
+/*
+    Simple http-client written to be an drop-in code, focus is to be small
+    and easy to use but maybe not efficient.
+
+    version 1.0, June, 2014
+
+	Copyright (C) 2014- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+#define URL_PARSER_IMPLEMENTATION_STATIC
+
+#include <http_client/http_client_pool.h>
+#include "http_client_internal.h"
+
+#include <stdio.h>
+#include <string.h>
+
+struct http_pool_idle
+{
+	http_client_t client;
+	unsigned long long since; ///< time when connection was released to the pool.
+};
+
+struct http_pool_host
+{
+	http_pool_host* next;
+	char key[320];              ///< scheme://host:port
+	unsigned int leased;
+	http_pool_idle* idle;       ///< idle connections, most recently released last.
+	unsigned int num_idle;
+	unsigned int cap_idle;
+};
+
+struct http_client_pool
+{
+	http_client_mutex mutex;
+	http_client_pool_config config;
+	http_pool_host* hosts;
+	http_client_pool_stats stats;
+};
+
+static bool http_pool_make_key( const parsed_url* url, char* key, size_t key_size )
+{
+	unsigned int port = url->port == 0 ? 80 : url->port;
+	int len = snprintf( key, key_size, "%s://%s:%u", url->scheme ? url->scheme : "http", url->host, port );
+	return len > 0 && (size_t)len < key_size;
+}
+
+static void http_pool_destroy_client( http_client_t client )
+{
+	http_client_disconnect( client );
+	free( client );
+}
+
+static http_pool_host* http_pool_find_host( http_client_pool_t pool, const char* key, bool create )
+{
+	for( http_pool_host* host = pool->hosts; host != 0x0; host = host->next )
+		if( strcmp( host->key, key ) == 0 )
+			return host;
+
+	if( !create )
+		return 0x0;
+
+	http_pool_host* host = (http_pool_host*)malloc( sizeof( http_pool_host ) );
+	if( host == 0x0 )
+		return 0x0;
+	memset( host, 0x0, sizeof( http_pool_host ) );
+	strcpy( host->key, key );
+	host->next = pool->hosts;
+	pool->hosts = host;
+	return host;
+}
+
+/**
+ * Close connections idle longer than idle_timeout, expects pool to be locked.
+ */
+static void http_pool_evict_host( http_client_pool_t pool, http_pool_host* host, unsigned long long now )
+{
+	if( pool->config.idle_timeout == 0 )
+		return;
+
+	// ... idle-list is sorted by release-time so all expired connections are at the front ...
+	unsigned int expired = 0;
+	while( expired < host->num_idle && now - host->idle[expired].since > pool->config.idle_timeout )
+		http_pool_destroy_client( host->idle[expired++].client );
+
+	if( expired == 0 )
+		return;
+
+	host->num_idle -= expired;
+	memmove( host->idle, host->idle + expired, host->num_idle * sizeof( http_pool_idle ) );
+	pool->stats.evicted += expired;
+	pool->stats.idle    -= expired;
+}
+
+http_client_result http_client_pool_create( http_client_pool_t* pool, const http_client_pool_config* config )
+{
+	http_client_pool* p = (http_client_pool*)malloc( sizeof( http_client_pool ) );
+	if( p == 0x0 )
+		return HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+
+	memset( p, 0x0, sizeof( http_client_pool ) );
+	if( config )
+		p->config = *config;
+	http_client_mutex_init( &p->mutex );
+
+	*pool = p;
+	return HTTP_CLIENT_OK;
+}
+
+void http_client_pool_destroy( http_client_pool_t pool )
+{
+	http_pool_host* host = pool->hosts;
+	while( host )
+	{
+		http_pool_host* next = host->next;
+		for( unsigned int i = 0; i < host->num_idle; ++i )
+			http_pool_destroy_client( host->idle[i].client );
+		free( host->idle );
+		free( host );
+		host = next;
+	}
+
+	http_client_mutex_destroy( &pool->mutex );
+	free( pool );
+}
+
+http_client_result http_client_pool_acquire( http_client_pool_t pool, const char* url, http_client_t* client )
+{
+	*client = 0x0;
+
+	char key[320];
+	char urlmem[512];
+	size_t urlmem_size = parse_url_calc_mem_usage( url );
+	void* mem = urlmem_size <= sizeof( urlmem ) ? urlmem : 0x0;
+	parsed_url* parsed = parse_url( url, mem, sizeof( urlmem ) );
+	if( parsed == 0x0 )
+		return HTTP_CLIENT_INVALID_URL;
+	bool key_ok = http_pool_make_key( parsed, key, sizeof( key ) );
+	if( mem == 0x0 )
+		free( parsed );
+	if( !key_ok )
+		return HTTP_CLIENT_INVALID_URL;
+
+	http_client_mutex_lock( &pool->mutex );
+
+	http_pool_host* host = http_pool_find_host( pool, key, true );
+	if( host == 0x0 )
+	{
+		http_client_mutex_unlock( &pool->mutex );
+		return HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+	}
+
+	http_pool_evict_host( pool, host, http_client_time_ms() );
+
+	while( host->num_idle > 0 )
+	{
+		http_client_t c = host->idle[--host->num_idle].client;
+		++host->leased;
+		++pool->stats.leased;
+		--pool->stats.idle;
+
+		// ... check liveness without holding the lock, the connection is ours now ...
+		http_client_mutex_unlock( &pool->mutex );
+		bool alive = c->sockfd >= 0 && http_client_socket_alive( c->sockfd );
+		if( !alive )
+			http_pool_destroy_client( c );
+		http_client_mutex_lock( &pool->mutex );
+
+		if( alive )
+		{
+			++pool->stats.hits;
+			http_client_mutex_unlock( &pool->mutex );
+			*client = c;
+			return HTTP_CLIENT_OK;
+		}
+
+		--host->leased;
+		--pool->stats.leased;
+		++pool->stats.dead;
+	}
+
+	if( pool->config.max_per_host != 0 && host->leased >= pool->config.max_per_host )
+	{
+		http_client_mutex_unlock( &pool->mutex );
+		return HTTP_CLIENT_POOL_EXHAUSTED;
+	}
+
+	// ... reserve the slot and connect without holding the lock ...
+	++host->leased;
+	++pool->stats.leased;
+	++pool->stats.misses;
+	http_client_mutex_unlock( &pool->mutex );
+
+	size_t recv_buffer_size = pool->config.recv_buffer_size ? pool->config.recv_buffer_size : HTTP_CLIENT_DEFAULT_RECV_BUFFER_SIZE;
+	http_client_result res = http_client_connect_ex( client, url, pool->config.useragent, recv_buffer_size, 0x0, 0 );
+	if( res != HTTP_CLIENT_OK )
+	{
+		http_client_mutex_lock( &pool->mutex );
+		--host->leased;
+		--pool->stats.leased;
+		http_client_mutex_unlock( &pool->mutex );
+		return res;
+	}
+
+	http_client_set_cache( *client, pool->config.cache );
+	return res;
+}
+
+void http_client_pool_release( http_client_pool_t pool, http_client_t client )
+{
+	char key[320];
+	if( !http_pool_make_key( client->url, key, sizeof( key ) ) )
+	{
+		http_pool_destroy_client( client );
+		return;
+	}
+
+	http_client_mutex_lock( &pool->mutex );
+
+	http_pool_host* host = http_pool_find_host( pool, key, false );
+	if( host == 0x0 )
+	{
+		// ... not acquired from this pool ...
+		http_client_mutex_unlock( &pool->mutex );
+		http_pool_destroy_client( client );
+		return;
+	}
+
+	--host->leased;
+	--pool->stats.leased;
+
+	bool keep = client->sockfd >= 0;
+	if( keep && host->num_idle == host->cap_idle )
+	{
+		unsigned int new_cap = host->cap_idle == 0 ? 4 : host->cap_idle * 2;
+		http_pool_idle* idle = (http_pool_idle*)realloc( host->idle, new_cap * sizeof( http_pool_idle ) );
+		if( idle == 0x0 )
+			keep = false;
+		else
+		{
+			host->idle = idle;
+			host->cap_idle = new_cap;
+		}
+	}
+
+	if( keep )
+	{
+		host->idle[host->num_idle].client = client;
+		host->idle[host->num_idle].since  = http_client_time_ms();
+		++host->num_idle;
+		++pool->stats.idle;
+	}
+
+	http_client_mutex_unlock( &pool->mutex );
+
+	if( !keep )
+		http_pool_destroy_client( client );
+}
+
+void http_client_pool_evict( http_client_pool_t pool )
+{
+	http_client_mutex_lock( &pool->mutex );
+	unsigned long long now = http_client_time_ms();
+	for( http_pool_host* host = pool->hosts; host != 0x0; host = host->next )
+		http_pool_evict_host( pool, host, now );
+	http_client_mutex_unlock( &pool->mutex );
+}
+
+void http_client_pool_get_stats( http_client_pool_t pool, http_client_pool_stats* stats )
+{
+	http_client_mutex_lock( &pool->mutex );
+	*stats = pool->stats;
+	http_client_mutex_unlock( &pool->mutex );
+}
@@ -0,0 +1,551 @@
+/*
+    Simple http-client written to be an drop-in code, focus is to be small
+    and easy to use but maybe not efficient.
+
+    version 1.0, June, 2014
+
+	Copyright (C) 2014- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+#include <http_client/http_client_resolver.h>
+#include "http_client_internal.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define HTTP_RESOLVER_MAX_THREADS 16
+#define HTTP_RESOLVER_MAX_HOST    256
+
+#if defined( _MSC_VER )
+	typedef HANDLE http_resolver_thread;
+#else
+	typedef pthread_t http_resolver_thread;
+#endif
+
+enum http_resolver_entry_state
+{
+	HTTP_RESOLVER_QUEUED,    ///< waiting for a resolver thread to pick it up.
+	HTTP_RESOLVER_RESOLVING, ///< lookup in flight.
+	HTTP_RESOLVER_DONE
+};
+
+struct http_resolver_waiter
+{
+	http_resolver_waiter* next;
+	http_client_resolve_callback callback;
+	void* userdata;
+};
+
+struct http_resolver_entry
+{
+	http_resolver_entry* next;
+
+	char host[HTTP_RESOLVER_MAX_HOST];
+	unsigned int port;
+	http_resolver_entry_state state;
+	unsigned int refs;               ///< threads resolving or waiting for this entry, it is not evicted while > 0.
+	unsigned long long expires;      ///< time in ms when a done entry is no longer valid.
+	unsigned long long last_used;
+
+	http_client_result result;
+	http_client_addr_list addrs;     ///< only valid if result is HTTP_CLIENT_OK.
+	http_resolver_waiter* waiters;   ///< callbacks to call when the lookup is done.
+};
+
+struct http_client_resolver
+{
+	http_client_mutex mutex;
+	http_client_cond  cond;          ///< broadcast when a lookup is queued, a lookup is done or on shutdown.
+	http_client_resolver_config config;
+	http_client_resolver_stats stats;
+	http_resolver_entry* entries;
+	bool shutdown;
+
+	unsigned int num_threads;
+	http_resolver_thread threads[HTTP_RESOLVER_MAX_THREADS];
+};
+
+static http_client_resolver* http_resolver_default = 0x0;
+
+http_client_result http_client_getaddrinfo( const char* host, unsigned int port, http_client_addr_list* addrs )
+{
+	addrinfo hints;
+	memset( &hints, 0x0, sizeof(hints) );
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	char service[8];
+	snprintf( service, 8, "%u", port );
+	addrinfo* result;
+	if( getaddrinfo( host, service, &hints, &result ) != 0 )
+		return HTTP_CLIENT_SOCKET_ERROR;
+
+	// ... interleave address families, starting with the one preferred by the system, as in rfc 8305 section 4 ...
+	addrinfo* first[HTTP_CLIENT_MAX_ADDRS];
+	addrinfo* other[HTTP_CLIENT_MAX_ADDRS];
+	unsigned int num_first = 0;
+	unsigned int num_other = 0;
+	for( addrinfo* res_iter = result; res_iter != 0x0; res_iter = res_iter->ai_next )
+	{
+		if( res_iter->ai_addrlen > sizeof( sockaddr_storage ) )
+			continue;
+		if( res_iter->ai_family == result->ai_family )
+		{
+			if( num_first < HTTP_CLIENT_MAX_ADDRS )
+				first[num_first++] = res_iter;
+		}
+		else if( num_other < HTTP_CLIENT_MAX_ADDRS )
+			other[num_other++] = res_iter;
+	}
+
+	addrs->count = 0;
+	for( unsigned int i = 0; addrs->count < HTTP_CLIENT_MAX_ADDRS && ( i < num_first || i < num_other ); ++i )
+	{
+		addrinfo* pick[2] = { i < num_first ? first[i] : 0x0, i < num_other ? other[i] : 0x0 };
+		for( int p = 0; p < 2 && addrs->count < HTTP_CLIENT_MAX_ADDRS; ++p )
+		{
+			if( pick[p] == 0x0 )
+				continue;
+			memcpy( &addrs->addrs[addrs->count], pick[p]->ai_addr, pick[p]->ai_addrlen );
+			addrs->lens[addrs->count] = (socklen_t)pick[p]->ai_addrlen;
+			++addrs->count;
+		}
+	}
+	freeaddrinfo( result );
+
+	return addrs->count > 0 ? HTTP_CLIENT_OK : HTTP_CLIENT_SOCKET_ERROR;
+}
+
+static http_resolver_entry* http_resolver_find( http_client_resolver* resolver, const char* host, unsigned int port )
+{
+	for( http_resolver_entry* entry = resolver->entries; entry != 0x0; entry = entry->next )
+		if( entry->port == port && strncasecmp( entry->host, host, sizeof( entry->host ) ) == 0 )
+			return entry;
+	return 0x0;
+}
+
+static bool http_resolver_entry_valid( const http_resolver_entry* entry, unsigned long long now )
+{
+	return entry->state == HTTP_RESOLVER_DONE && now < entry->expires;
+}
+
+static bool http_resolver_entry_evictable( const http_resolver_entry* entry )
+{
+	return entry->state == HTTP_RESOLVER_DONE && entry->refs == 0;
+}
+
+static void http_resolver_remove( http_client_resolver* resolver, http_resolver_entry** link )
+{
+	http_resolver_entry* entry = *link;
+	*link = entry->next;
+	free( entry );
+	--resolver->stats.entries;
+}
+
+/**
+ * Make room for a new entry, first by dropping expired entries and then the least recently used. Expects resolver
+ * to be locked.
+ */
+static void http_resolver_evict( http_client_resolver* resolver, unsigned long long now )
+{
+	if( resolver->stats.entries < resolver->config.max_entries )
+		return;
+
+	for( http_resolver_entry** it = &resolver->entries; *it; )
+	{
+		if( http_resolver_entry_evictable( *it ) && !http_resolver_entry_valid( *it, now ) )
+			http_resolver_remove( resolver, it );
+		else
+			it = &(*it)->next;
+	}
+
+	while( resolver->stats.entries >= resolver->config.max_entries )
+	{
+		http_resolver_entry** lru = 0x0;
+		for( http_resolver_entry** it = &resolver->entries; *it; it = &(*it)->next )
+			if( http_resolver_entry_evictable( *it ) && ( lru == 0x0 || (*it)->last_used < (*lru)->last_used ) )
+				lru = it;
+
+		// ... everything is in flight, go above max_entries for a while ...
+		if( lru == 0x0 )
+			return;
+
+		http_resolver_remove( resolver, lru );
+		++resolver->stats.evicted;
+	}
+}
+
+static http_resolver_entry* http_resolver_insert( http_client_resolver* resolver, const char* host, unsigned int port, unsigned long long now )
+{
+	http_resolver_evict( resolver, now );
+
+	http_resolver_entry* entry = (http_resolver_entry*)malloc( sizeof( http_resolver_entry ) );
+	if( entry == 0x0 )
+		return 0x0;
+
+	memset( entry, 0x0, sizeof( http_resolver_entry ) );
+	strcpy( entry->host, host );
+	entry->port = port;
+	entry->last_used = now;
+	entry->next = resolver->entries;
+	resolver->entries = entry;
+	++resolver->stats.entries;
+	return entry;
+}
+
+/**
+ * Store the result of a lookup in entry and call everyone waiting for it. Expects resolver to be locked.
+ */
+static void http_resolver_complete( http_client_resolver* resolver, http_resolver_entry* entry, http_client_result result, const http_client_addr_list* addrs )
+{
+	unsigned long long now = http_client_time_ms();
+	entry->state   = HTTP_RESOLVER_DONE;
+	entry->result  = result;
+	entry->expires = now + ( result == HTTP_CLIENT_OK ? resolver->config.ttl : resolver->config.negative_ttl );
+	if( result == HTTP_CLIENT_OK )
+		entry->addrs = *addrs;
+	else
+		++resolver->stats.failures;
+
+	http_resolver_waiter* waiter = entry->waiters;
+	entry->waiters = 0x0;
+	while( waiter )
+	{
+		http_resolver_waiter* next = waiter->next;
+		waiter->callback( result, waiter->userdata );
+		free( waiter );
+		waiter = next;
+	}
+
+	http_client_cond_broadcast( &resolver->cond );
+}
+
+/**
+ * Run lookups of queued entries until the resolver is shut down.
+ */
+static void http_resolver_work( http_client_resolver* resolver )
+{
+	http_client_mutex_lock( &resolver->mutex );
+	while( !resolver->shutdown )
+	{
+		http_resolver_entry* entry = resolver->entries;
+		while( entry != 0x0 && entry->state != HTTP_RESOLVER_QUEUED )
+			entry = entry->next;
+
+		if( entry == 0x0 )
+		{
+			http_client_cond_wait( &resolver->cond, &resolver->mutex );
+			continue;
+		}
+
+		// ... entry is kept alive by refs, host and port never change for an entry ...
+		entry->state = HTTP_RESOLVER_RESOLVING;
+		++entry->refs;
+		http_client_mutex_unlock( &resolver->mutex );
+
+		http_client_addr_list addrs;
+		http_client_result res = http_client_getaddrinfo( entry->host, entry->port, &addrs );
+
+		http_client_mutex_lock( &resolver->mutex );
+		--entry->refs;
+		http_resolver_complete( resolver, entry, res, &addrs );
+	}
+	http_client_mutex_unlock( &resolver->mutex );
+}
+
+#if defined( _MSC_VER )
+static DWORD WINAPI http_resolver_thread_main( LPVOID arg )
+#else
+static void* http_resolver_thread_main( void* arg )
+#endif
+{
+	http_resolver_work( (http_client_resolver*)arg );
+	return 0;
+}
+
+http_client_result http_client_resolver_create( http_client_resolver_t* resolver, const http_client_resolver_config* config )
+{
+	http_client_resolver* r = (http_client_resolver*)malloc( sizeof( http_client_resolver ) );
+	if( r == 0x0 )
+		return HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+
+	memset( r, 0x0, sizeof( http_client_resolver ) );
+	if( config )
+		r->config = *config;
+	if( r->config.ttl == 0 )          r->config.ttl = 60000;
+	if( r->config.negative_ttl == 0 ) r->config.negative_ttl = 5000;
+	if( r->config.max_entries == 0 )  r->config.max_entries = 256;
+	if( r->config.num_threads == 0 )  r->config.num_threads = 2;
+	if( r->config.num_threads > HTTP_RESOLVER_MAX_THREADS )
+		r->config.num_threads = HTTP_RESOLVER_MAX_THREADS;
+
+	http_client_mutex_init( &r->mutex );
+	http_client_cond_init( &r->cond );
+
+	for( ; r->num_threads < r->config.num_threads; ++r->num_threads )
+	{
+#if defined( _MSC_VER )
+		r->threads[r->num_threads] = CreateThread( 0x0, 0, http_resolver_thread_main, r, 0, 0x0 );
+		if( r->threads[r->num_threads] == 0x0 )
+			break;
+#else
+		if( pthread_create( &r->threads[r->num_threads], 0x0, http_resolver_thread_main, r ) != 0 )
+			break;
+#endif
+	}
+
+	if( r->num_threads == 0 )
+	{
+		http_client_resolver_destroy( r );
+		return HTTP_CLIENT_INTERNAL_ERROR;
+	}
+
+	*resolver = r;
+	return HTTP_CLIENT_OK;
+}
+
+void http_client_resolver_destroy( http_client_resolver_t resolver )
+{
+	http_client_mutex_lock( &resolver->mutex );
+	resolver->shutdown = true;
+	http_client_cond_broadcast( &resolver->cond );
+	http_client_mutex_unlock( &resolver->mutex );
+
+	for( unsigned int i = 0; i < resolver->num_threads; ++i )
+	{
+#if defined( _MSC_VER )
+		WaitForSingleObject( resolver->threads[i], INFINITE );
+		CloseHandle( resolver->threads[i] );
+#else
+		pthread_join( resolver->threads[i], 0x0 );
+#endif
+	}
+
+	// ... all threads are done, only queued entries can have waiters left ...
+	while( resolver->entries )
+	{
+		http_resolver_entry* entry = resolver->entries;
+		resolver->entries = entry->next;
+		while( entry->waiters )
+		{
+			http_resolver_waiter* waiter = entry->waiters;
+			entry->waiters = waiter->next;
+			waiter->callback( HTTP_CLIENT_ABORTED, waiter->userdata );
+			free( waiter );
+		}
+		free( entry );
+	}
+
+	http_client_cond_destroy( &resolver->cond );
+	http_client_mutex_destroy( &resolver->mutex );
+	free( resolver );
+}
+
+void http_client_resolver_set_default( http_client_resolver_t resolver )
+{
+	http_resolver_default = resolver;
+}
+
+http_client_resolver* http_client_resolver_get_default()
+{
+	return http_resolver_default;
+}
+
+http_client_result http_client_resolve( http_client_resolver* resolver, const char* host, unsigned int port, http_client_addr_list* addrs )
+{
+	if( resolver == 0x0 || strlen( host ) >= HTTP_RESOLVER_MAX_HOST )
+		return http_client_getaddrinfo( host, port, addrs );
+
+	http_client_mutex_lock( &resolver->mutex );
+
+	unsigned long long now = http_client_time_ms();
+	http_resolver_entry* entry = http_resolver_find( resolver, host, port );
+	if( entry != 0x0 && http_resolver_entry_valid( entry, now ) )
+	{
+		++resolver->stats.hits;
+	}
+	else if( entry != 0x0 && entry->state == HTTP_RESOLVER_RESOLVING )
+	{
+		++resolver->stats.coalesced;
+		++entry->refs;
+		while( entry->state != HTTP_RESOLVER_DONE )
+			http_client_cond_wait( &resolver->cond, &resolver->mutex );
+		--entry->refs;
+	}
+	else
+	{
+		// ... not cached, expired or queued but not yet picked up by a resolver thread, resolve it here ...
+		if( entry == 0x0 )
+			entry = http_resolver_insert( resolver, host, port, now );
+		if( entry == 0x0 )
+		{
+			http_client_mutex_unlock( &resolver->mutex );
+			return HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+		}
+
+		++resolver->stats.misses;
+		entry->state = HTTP_RESOLVER_RESOLVING;
+		++entry->refs;
+		http_client_mutex_unlock( &resolver->mutex );
+
+		http_client_result res = http_client_getaddrinfo( host, port, addrs );
+
+		http_client_mutex_lock( &resolver->mutex );
+		--entry->refs;
+		http_resolver_complete( resolver, entry, res, addrs );
+	}
+
+	entry->last_used = now;
+	http_client_result res = entry->result;
+	if( res == HTTP_CLIENT_OK )
+		*addrs = entry->addrs;
+
+	http_client_mutex_unlock( &resolver->mutex );
+	return res;
+}
+
+bool http_client_resolver_peek( http_client_resolver* resolver, const char* host, unsigned int port, http_client_addr_list* addrs, http_client_result* result )
+{
+	http_client_mutex_lock( &resolver->mutex );
+
+	unsigned long long now = http_client_time_ms();
+	http_resolver_entry* entry = http_resolver_find( resolver, host, port );
+	bool found = entry != 0x0 && http_resolver_entry_valid( entry, now );
+	if( found )
+	{
+		++resolver->stats.hits;
+		entry->last_used = now;
+		*result = entry->result;
+		if( entry->result == HTTP_CLIENT_OK )
+			*addrs = entry->addrs;
+	}
+
+	http_client_mutex_unlock( &resolver->mutex );
+	return found;
+}
+
+http_client_result http_client_resolver_resolve_async( http_client_resolver_t resolver,
+													   const char* host,
+													   unsigned int port,
+													   http_client_resolve_callback callback,
+													   void* userdata )
+{
+	if( strlen( host ) >= HTTP_RESOLVER_MAX_HOST )
+		return HTTP_CLIENT_INVALID_URL;
+
+	http_client_mutex_lock( &resolver->mutex );
+
+	unsigned long long now = http_client_time_ms();
+	http_resolver_entry* entry = http_resolver_find( resolver, host, port );
+	if( entry != 0x0 && http_resolver_entry_valid( entry, now ) )
+	{
+		++resolver->stats.hits;
+		entry->last_used = now;
+		http_client_result res = entry->result;
+		http_client_mutex_unlock( &resolver->mutex );
+
+		if( callback )
+			callback( res, userdata );
+		return HTTP_CLIENT_OK;
+	}
+
+	if( entry == 0x0 || entry->state == HTTP_RESOLVER_DONE )
+	{
+		if( entry == 0x0 )
+			entry = http_resolver_insert( resolver, host, port, now );
+		if( entry == 0x0 )
+		{
+			http_client_mutex_unlock( &resolver->mutex );
+			return HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+		}
+
+		++resolver->stats.misses;
+		entry->state = HTTP_RESOLVER_QUEUED;
+		http_client_cond_broadcast( &resolver->cond );
+	}
+	else
+		++resolver->stats.coalesced;
+
+	entry->last_used = now;
+
+	// ... the same callback/userdata is only called once per lookup, callers can poll without piling up waiters ...
+	bool waiting = callback == 0x0;
+	for( http_resolver_waiter* waiter = entry->waiters; waiter != 0x0 && !waiting; waiter = waiter->next )
+		waiting = waiter->callback == callback && waiter->userdata == userdata;
+
+	http_client_result res = HTTP_CLIENT_OK;
+	if( !waiting )
+	{
+		http_resolver_waiter* waiter = (http_resolver_waiter*)malloc( sizeof( http_resolver_waiter ) );
+		if( waiter == 0x0 )
+			res = HTTP_CLIENT_MEMORY_ALLOC_ERROR;
+		else
+		{
+			waiter->callback = callback;
+			waiter->userdata = userdata;
+			waiter->next = entry->waiters;
+			entry->waiters = waiter;
+		}
+	}
+
+	http_client_mutex_unlock( &resolver->mutex );
+	return res;
+}
+
+void http_client_resolver_cancel( http_client_resolver_t resolver, http_client_resolve_callback callback, void* userdata )
+{
+	http_client_mutex_lock( &resolver->mutex );
+	for( http_resolver_entry* entry = resolver->entries; entry != 0x0; entry = entry->next )
+	{
+		for( http_resolver_waiter** it = &entry->waiters; *it; )
+		{
+			http_resolver_waiter* waiter = *it;
+			if( waiter->callback == callback && waiter->userdata == userdata )
+			{
+				*it = waiter->next;
+				free( waiter );
+			}
+			else
+				it = &waiter->next;
+		}
+	}
+	http_client_mutex_unlock( &resolver->mutex );
+}
+
+void http_client_resolver_flush( http_client_resolver_t resolver )
+{
+	http_client_mutex_lock( &resolver->mutex );
+	for( http_resolver_entry** it = &resolver->entries; *it; )
+	{
+		if( http_resolver_entry_evictable( *it ) )
+			http_resolver_remove( resolver, it );
+		else
+			it = &(*it)->next;
+	}
+	http_client_mutex_unlock( &resolver->mutex );
+}
+
+void http_client_resolver_get_stats( http_client_resolver_t resolver, http_client_resolver_stats* stats )
+{
+	http_client_mutex_lock( &resolver->mutex );
+	*stats = resolver->stats;
+	http_client_mutex_unlock( &resolver->mutex );
+}
@@ -0,0 +1,239 @@
+/*
+    Simple http-client written to be an drop-in code, focus is to be small
+    and easy to use but maybe not efficient.
+
+    version 1.0, June, 2014
+
+	Copyright (C) 2014- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+#include "http_client_scan.h"
+#include "http_client_header_hash.inl"
+
+#if HTTP_CLIENT_SCAN_X86
+#  include <emmintrin.h>
+#  include <immintrin.h>
+#  if defined( _MSC_VER )
+#    include <intrin.h>
+#  endif
+#endif
+
+#if defined( _MSC_VER )
+#  define HTTP_CLIENT_TARGET_AVX2
+#else
+#  define HTTP_CLIENT_TARGET_AVX2 __attribute__(( target( "avx2" ) ))
+#endif
+
+struct http_scan_state
+{
+	http_scan_line* lines;
+	size_t max_lines;
+	size_t num_lines;
+	size_t line_start;
+	size_t colon;      ///< first ':' on current line or (size_t)-1 if none found yet.
+};
+
+static inline void http_scan_state_init( http_scan_state* st, http_scan_line* lines, size_t max_lines )
+{
+	st->lines      = lines;
+	st->max_lines  = max_lines;
+	st->num_lines  = 0;
+	st->line_start = 0;
+	st->colon      = (size_t)-1;
+}
+
+/**
+ * Handle a '\n' or ':' at pos, return true when scanning is done.
+ */
+static inline bool http_scan_hit( const char* data, size_t pos, http_scan_state* st )
+{
+	if( data[pos] == ':' )
+	{
+		if( st->colon == (size_t)-1 )
+			st->colon = pos;
+		return false;
+	}
+
+	size_t end = pos > st->line_start && data[pos - 1] == '\r' ? pos - 1 : pos;
+	http_scan_line* line = &st->lines[st->num_lines++];
+	line->start = st->line_start;
+	line->colon = st->colon == (size_t)-1 ? end : st->colon;
+	line->end   = end;
+
+	st->line_start = pos + 1;
+	st->colon      = (size_t)-1;
+	return end == line->start || st->num_lines == st->max_lines;
+}
+
+static inline size_t http_scan_finish( http_scan_state* st, size_t* consumed )
+{
+	*consumed = st->line_start;
+	return st->num_lines;
+}
+
+/**
+ * Handle all hits in mask, bit n of mask is set for a '\n' or ':' at base + n.
+ */
+static inline bool http_scan_mask( const char* data, size_t base, unsigned int mask, http_scan_state* st )
+{
+	while( mask != 0 )
+	{
+#if defined( _MSC_VER )
+		unsigned long bit;
+		_BitScanForward( &bit, mask );
+#else
+		unsigned int bit = (unsigned int)__builtin_ctz( mask );
+#endif
+		mask &= mask - 1;
+		if( http_scan_hit( data, base + bit, st ) )
+			return true;
+	}
+	return false;
+}
+
+static size_t http_scan_tail( const char* data, size_t pos, size_t size, http_scan_state* st, size_t* consumed )
+{
+	for( ; pos < size; ++pos )
+	{
+		if( data[pos] != '\n' && data[pos] != ':' )
+			continue;
+		if( http_scan_hit( data, pos, st ) )
+			break;
+	}
+	return http_scan_finish( st, consumed );
+}
+
+size_t http_client_scan_lines_scalar( const char* data, size_t size, http_scan_line* lines, size_t max_lines, size_t* consumed )
+{
+	http_scan_state st;
+	http_scan_state_init( &st, lines, max_lines );
+	if( max_lines == 0 )
+		return http_scan_finish( &st, consumed );
+	return http_scan_tail( data, 0, size, &st, consumed );
+}
+
+#if HTTP_CLIENT_SCAN_X86
+
+size_t http_client_scan_lines_sse2( const char* data, size_t size, http_scan_line* lines, size_t max_lines, size_t* consumed )
+{
+	http_scan_state st;
+	http_scan_state_init( &st, lines, max_lines );
+	if( max_lines == 0 )
+		return http_scan_finish( &st, consumed );
+
+	const __m128i nl    = _mm_set1_epi8( '\n' );
+	const __m128i colon = _mm_set1_epi8( ':' );
+
+	size_t pos = 0;
+	for( ; pos + 16 <= size; pos += 16 )
+	{
+		__m128i v = _mm_loadu_si128( (const __m128i*)( data + pos ) );
+		__m128i hits = _mm_or_si128( _mm_cmpeq_epi8( v, nl ), _mm_cmpeq_epi8( v, colon ) );
+		if( http_scan_mask( data, pos, (unsigned int)_mm_movemask_epi8( hits ), &st ) )
+			return http_scan_finish( &st, consumed );
+	}
+	return http_scan_tail( data, pos, size, &st, consumed );
+}
+
+HTTP_CLIENT_TARGET_AVX2
+size_t http_client_scan_lines_avx2( const char* data, size_t size, http_scan_line* lines, size_t max_lines, size_t* consumed )
+{
+	http_scan_state st;
+	http_scan_state_init( &st, lines, max_lines );
+	if( max_lines == 0 )
+		return http_scan_finish( &st, consumed );
+
+	const __m256i nl    = _mm256_set1_epi8( '\n' );
+	const __m256i colon = _mm256_set1_epi8( ':' );
+
+	size_t pos = 0;
+	for( ; pos + 32 <= size; pos += 32 )
+	{
+		__m256i v = _mm256_loadu_si256( (const __m256i*)( data + pos ) );
+		__m256i hits = _mm256_or_si256( _mm256_cmpeq_epi8( v, nl ), _mm256_cmpeq_epi8( v, colon ) );
+		if( http_scan_mask( data, pos, (unsigned int)_mm256_movemask_epi8( hits ), &st ) )
+			return http_scan_finish( &st, consumed );
+	}
+	return http_scan_tail( data, pos, size, &st, consumed );
+}
+
+bool http_client_scan_has_avx2()
+{
+#if defined( _MSC_VER )
+	int info[4];
+	__cpuid( info, 1 );
+	bool osxsave = ( info[2] & ( 1 << 27 ) ) != 0;
+	bool avx     = ( info[2] & ( 1 << 28 ) ) != 0;
+	if( !osxsave || !avx || ( _xgetbv( 0 ) & 6 ) != 6 )
+		return false;
+	__cpuidex( info, 7, 0 );
+	return ( info[1] & ( 1 << 5 ) ) != 0;
+#else
+	return __builtin_cpu_supports( "avx2" );
+#endif
+}
+
+#endif // HTTP_CLIENT_SCAN_X86
+
+typedef size_t (*http_scan_lines_func)( const char* data, size_t size, http_scan_line* lines, size_t max_lines, size_t* consumed );
+
+static http_scan_lines_func http_client_scan_select()
+{
+#if HTTP_CLIENT_SCAN_X86
+	// ... sse2 is part of x86-64 so always available ...
+	return http_client_scan_has_avx2() ? http_client_scan_lines_avx2 : http_client_scan_lines_sse2;
+#else
+	return http_client_scan_lines_scalar;
+#endif
+}
+
+size_t http_client_scan_lines( const char* data, size_t size, http_scan_line* lines, size_t max_lines, size_t* consumed )
+{
+	static const http_scan_lines_func scan = http_client_scan_select();
+	return scan( data, size, lines, max_lines, consumed );
+}
+
+/**
+ * Compare name to the lowercase literal lit, case-insensitive.
+ */
+static inline bool http_client_name_equals( const char* name, const char* lit, size_t length )
+{
+	for( size_t i = 0; i < length; ++i )
+	{
+		char c = name[i];
+		if( c >= 'A' && c <= 'Z' )
+			c = (char)( c + ( 'a' - 'A' ) );
+		if( c != lit[i] )
+			return false;
+	}
+	return true;
+}
+
+http_client_header_id http_client_classify_header( const char* name, size_t length )
+{
+	if( length < HTTP_CLIENT_HEADER_MIN_NAME_LENGTH || length > HTTP_CLIENT_HEADER_MAX_NAME_LENGTH )
+		return HTTP_CLIENT_HEADER_UNKNOWN;
+
+	const http_header_hash_entry* entry = &http_header_hash_table[ http_header_hash( name, length ) ];
+	if( entry->length != length || !http_client_name_equals( name, entry->name, length ) )
+		return HTTP_CLIENT_HEADER_UNKNOWN;
+	return (http_client_header_id)entry->id;
+}
@@ -0,0 +1,96 @@
+/*
+    Simple http-client written to be an drop-in code, focus is to be small
+    and easy to use but maybe not efficient.
+
+    version 1.0, June, 2014
+
+	Copyright (C) 2014- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+#ifndef HTTP_CLIENT_SCAN_H_INCLUDED
+#define HTTP_CLIENT_SCAN_H_INCLUDED
+
+/**
+ * Scanning of header blocks, finds line-breaks and ':' separators in a block of received data in one pass and
+ * classifies the header names that http_client acts on. Not part of the public api.
+ */
+
+#include <stddef.h>
+
+#include <http_client/http_client_headers.h>
+
+#if defined( __x86_64__ ) || defined( _M_X64 )
+#  define HTTP_CLIENT_SCAN_X86 1
+#else
+#  define HTTP_CLIENT_SCAN_X86 0
+#endif
+
+/**
+ * A line found by http_client_scan_lines(), all members are offsets from the start of the scanned data.
+ */
+struct http_scan_line
+{
+	size_t start;
+	size_t colon; ///< first ':' of the line, same as end if the line has none.
+	size_t end;   ///< end of the line, excluding CRLF or LF.
+};
+
+/**
+ * Find complete lines in data, stops after max_lines lines or after the first empty line, i.e. the end of a
+ * header block.
+ *
+ * @param data data to scan.
+ * @param size size of data.
+ * @param lines array to write found lines to.
+ * @param max_lines size of lines.
+ * @param consumed set to number of bytes covered by the found lines, including line-breaks.
+ *
+ * @return number of lines found.
+ */
+size_t http_client_scan_lines( const char* data, size_t size, http_scan_line* lines, size_t max_lines, size_t* consumed );
+
+/**
+ * Kernels behind http_client_scan_lines(), the fastest one supported by the cpu is selected on first use.
+ * Exposed for benchmarking.
+ */
+size_t http_client_scan_lines_scalar( const char* data, size_t size, http_scan_line* lines, size_t max_lines, size_t* consumed );
+#if HTTP_CLIENT_SCAN_X86
+size_t http_client_scan_lines_sse2( const char* data, size_t size, http_scan_line* lines, size_t max_lines, size_t* consumed );
+size_t http_client_scan_lines_avx2( const char* data, size_t size, http_scan_line* lines, size_t max_lines, size_t* consumed );
+
+/**
+ * Return true if cpu and os supports AVX2.
+ */
+bool http_client_scan_has_avx2();
+#endif
+
+/**
+ * Classify a header name as one of the well-known headers, case-insensitive. Uses the perfect hash generated by
+ * tools/gen_header_hash.py so that only one name is compared.
+ *
+ * @param name name of header, not including ':'.
+ * @param length length of name.
+ *
+ * @return id of header or HTTP_CLIENT_HEADER_UNKNOWN.
+ */
+http_client_header_id http_client_classify_header( const char* name, size_t length );
+
+#endif // HTTP_CLIENT_SCAN_H_INCLUDED
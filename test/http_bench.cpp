@@ -0,0 +1,639 @@
+/*
+    Simple http-client written to be an drop-in code, focus is to be small
+    and easy to use but maybe not efficient.
+
+    version 1.0, June, 2014
+
+	Copyright (C) 2014- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+/**
+ * Loopback benchmark for http_client, runs a minimal http-server on 127.0.0.1 in a background thread and measures
+ * requests against it.
+ *
+ * The server answers GET/HEAD of "/fixed/<size>" with a body of size bytes with Content-Length, "/chunked/<size>"
+ * with the same body in 4KB chunks and "/drip/<size>" with the body sent 1KB at a time 1ms apart. "/nolength/<status>"
+ * is answered with status and no Content-Length, only valid for responses without a body. "/etag/<size>" is as
+ * "/fixed/<size>" with an ETag and answered with a 304 without Content-Length when requested with If-None-Match.
+ * Anything else, i.e. POST, gets a 2 byte body.
+ *
+ * Before the benchmarks a few checks are run that responses without a body leave the connection reusable, the
+ * benchmark exits with an error if they fail.
+ *
+ * Each scenario runs iterations requests per connection on concurrency connections, each on its own thread, and
+ * reports requests/s, body bytes/s and latency percentiles over all requests.
+ *
+ * usage: http_bench [iterations] [filter]
+ *
+ *   filter only runs scenarios with filter in their name, i.e. "GET" or "c16".
+ */
+
+#include <http_client/http_client.h>
+#include <http_client/http_client_cache.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <algorithm>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/uio.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define BENCH_MAX_BODY (1024 * 1024)
+
+static char bench_body[BENCH_MAX_BODY];
+static unsigned int bench_server_accepted; ///< connections accepted by the loopback server.
+
+static double bench_time_us()
+{
+	timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (double)ts.tv_sec * 1000000.0 + (double)ts.tv_nsec / 1000.0;
+}
+
+static bool bench_send_all( int fd, const char* data, size_t size )
+{
+	while( size > 0 )
+	{
+		ssize_t res = send( fd, data, size, MSG_NOSIGNAL );
+		if( res < 0 && errno == EINTR )
+			continue;
+		if( res <= 0 )
+			return false;
+		data += res;
+		size -= (size_t)res;
+	}
+	return true;
+}
+
+/**
+ * Read one request, head and body, from fd and copy its method and path to verb and path, *conditional is set if it
+ * had an If-None-Match header. Returns false on EOF or error.
+ */
+static bool bench_server_read_request( int fd, char* buffer, size_t buffer_size, size_t* buffered, char verb[8], char path[128], bool* conditional )
+{
+	char* end = 0x0;
+	while( ( end = (char*)memmem( buffer, *buffered, "\r\n\r\n", 4 ) ) == 0x0 )
+	{
+		if( *buffered == buffer_size )
+			return false;
+		ssize_t res = recv( fd, buffer + *buffered, buffer_size - *buffered, 0 );
+		if( res <= 0 )
+			return false;
+		*buffered += (size_t)res;
+	}
+
+	// ... head ends with "\r\n\r\n" so %s stops within it ...
+	if( sscanf( buffer, "%7s %127s", verb, path ) != 2 )
+		return false;
+
+	size_t head_size = (size_t)( end + 4 - buffer );
+	size_t body_size = 0;
+	*conditional = false;
+	for( char* line = buffer; line < end; line = strstr( line, "\r\n" ) + 2 )
+	{
+		if( strncasecmp( line, "content-length:", 15 ) == 0 )
+			body_size = (size_t)strtoull( line + 15, 0x0, 10 );
+		else if( strncasecmp( line, "if-none-match:", 14 ) == 0 )
+			*conditional = true;
+	}
+
+	// ... consume body, we don't care about its content ...
+	size_t total = head_size + body_size;
+	while( *buffered < total )
+	{
+		size_t to_read = total - *buffered;
+		if( to_read > buffer_size - head_size )
+			to_read = buffer_size - head_size;
+		ssize_t res = recv( fd, buffer + head_size, to_read, 0 );
+		if( res <= 0 )
+			return false;
+		total -= (size_t)res;
+	}
+
+	*buffered -= total;
+	memmove( buffer, buffer + total, *buffered );
+	return true;
+}
+
+/**
+ * Send the response to verb of path, see top of file.
+ */
+static bool bench_server_respond( int fd, const char* verb, const char* path, bool conditional )
+{
+	static const char ok_response[] = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+	static const char not_modified_response[] = "HTTP/1.1 304 Not Modified\r\nETag: \"b\"\r\n\r\n";
+
+	char kind[16];
+	size_t size = 0;
+	if( sscanf( path, "/%15[a-z]/%zu", kind, &size ) != 2 || size > BENCH_MAX_BODY )
+		return bench_send_all( fd, ok_response, sizeof( ok_response ) - 1 );
+
+	bool head = strcmp( verb, "HEAD" ) == 0;
+	char buffer[256];
+	if( strcmp( kind, "nolength" ) == 0 )
+	{
+		int len = snprintf( buffer, sizeof( buffer ), "HTTP/1.1 %zu No Length\r\n\r\n", size );
+		return bench_send_all( fd, buffer, (size_t)len );
+	}
+	if( strcmp( kind, "chunked" ) == 0 )
+	{
+		int len = snprintf( buffer, sizeof( buffer ), "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n" );
+		if( !bench_send_all( fd, buffer, (size_t)len ) )
+			return false;
+		if( head )
+			return true;
+		for( size_t offset = 0; offset < size; offset += 4096 )
+		{
+			size_t chunk = size - offset < 4096 ? size - offset : 4096;
+			len = snprintf( buffer, sizeof( buffer ), "%zx\r\n", chunk );
+
+			// ... each chunk in one segment, as a server writing from a buffer would ...
+			iovec iov[3] = { { buffer, (size_t)len }, { bench_body + offset, chunk }, { (void*)"\r\n", 2 } };
+			if( writev( fd, iov, 3 ) != (ssize_t)( (size_t)len + chunk + 2 ) )
+				return false;
+		}
+		return bench_send_all( fd, "0\r\n\r\n", 5 );
+	}
+
+	bool etag = strcmp( kind, "etag" ) == 0;
+	if( etag && conditional )
+		return bench_send_all( fd, not_modified_response, sizeof( not_modified_response ) - 1 );
+
+	int len = snprintf( buffer, sizeof( buffer ), "HTTP/1.1 200 OK\r\n%sContent-Length: %zu\r\n\r\n", etag ? "ETag: \"b\"\r\n" : "", size );
+	if( !bench_send_all( fd, buffer, (size_t)len ) )
+		return false;
+	if( head )
+		return true;
+
+	if( strcmp( kind, "drip" ) == 0 )
+	{
+		for( size_t offset = 0; offset < size; offset += 1024 )
+		{
+			if( offset > 0 )
+				usleep( 1000 );
+			if( !bench_send_all( fd, bench_body + offset, size - offset < 1024 ? size - offset : 1024 ) )
+				return false;
+		}
+		return true;
+	}
+	return bench_send_all( fd, bench_body, size );
+}
+
+static void* bench_server_connection( void* arg )
+{
+	int fd = (int)(intptr_t)arg;
+
+	// ... responses are written in parts, don't let Nagle hold back the last one ...
+	int one = 1;
+	setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof( one ) );
+
+	char buffer[8192];
+	size_t buffered = 0;
+	char verb[8];
+	char path[128];
+	bool conditional;
+	while( bench_server_read_request( fd, buffer, sizeof( buffer ), &buffered, verb, path, &conditional ) )
+		if( !bench_server_respond( fd, verb, path, conditional ) )
+			break;
+
+	close( fd );
+	return 0x0;
+}
+
+static void* bench_server( void* arg )
+{
+	int listen_fd = (int)(intptr_t)arg;
+	while( true )
+	{
+		int fd = accept( listen_fd, 0x0, 0x0 );
+		if( fd < 0 )
+			break;
+		__sync_fetch_and_add( &bench_server_accepted, 1 );
+
+		pthread_t thread;
+		pthread_create( &thread, 0x0, bench_server_connection, (void*)(intptr_t)fd );
+		pthread_detach( thread );
+	}
+	return 0x0;
+}
+
+static unsigned short bench_start_server()
+{
+	int fd = socket( AF_INET, SOCK_STREAM, 0 );
+	int one = 1;
+	setsockopt( fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof( one ) );
+
+	sockaddr_in addr;
+	memset( &addr, 0x0, sizeof( addr ) );
+	addr.sin_family      = AF_INET;
+	addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+	addr.sin_port        = 0;
+	if( bind( fd, (sockaddr*)&addr, sizeof( addr ) ) < 0 || listen( fd, 128 ) < 0 )
+	{
+		fprintf( stderr, "failed to start loopback server: %s\n", strerror( errno ) );
+		exit( 1 );
+	}
+
+	socklen_t len = sizeof( addr );
+	getsockname( fd, (sockaddr*)&addr, &len );
+
+	pthread_t thread;
+	pthread_create( &thread, 0x0, bench_server, (void*)(intptr_t)fd );
+	pthread_detach( thread );
+	return ntohs( addr.sin_port );
+}
+
+static void bench_report( const char* name, double* samples, int count )
+{
+	std::sort( samples, samples + count );
+	double total = 0.0;
+	for( int i = 0; i < count; ++i )
+		total += samples[i];
+
+	printf( "%-32s avg %9.1fus  p50 %9.1fus  p99 %9.1fus  max %9.1fus\n",
+			name,
+			total / count,
+			samples[count / 2],
+			samples[(int)( count * 0.99 )],
+			samples[count - 1] );
+}
+
+/**
+ * Small POST the way http_client used to send it, headers and body in separate send() calls on a socket with Nagle
+ * enabled. Used as reference.
+ */
+static void bench_small_post_two_sends( unsigned short port, double* samples, int iterations )
+{
+	int fd = socket( AF_INET, SOCK_STREAM, 0 );
+	sockaddr_in addr;
+	memset( &addr, 0x0, sizeof( addr ) );
+	addr.sin_family      = AF_INET;
+	addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+	addr.sin_port        = htons( port );
+	if( connect( fd, (sockaddr*)&addr, sizeof( addr ) ) < 0 )
+	{
+		fprintf( stderr, "failed to connect to loopback server: %s\n", strerror( errno ) );
+		exit( 1 );
+	}
+
+	static const char head[] = "POST /post HTTP/1.1\r\nHost: 127.0.0.1\r\nUser-Agent: http-client\r\nContent-Length: 16\r\n\r\n";
+	static const char body[] = "0123456789abcdef";
+	char response[256];
+	for( int i = 0; i < iterations; ++i )
+	{
+		double start = bench_time_us();
+		bench_send_all( fd, head, sizeof( head ) - 1 );
+		bench_send_all( fd, body, sizeof( body ) - 1 );
+
+		// ... response is fixed size, read until it is all here ...
+		size_t got = 0;
+		while( got < 40 )
+		{
+			ssize_t res = recv( fd, response + got, sizeof( response ) - got, 0 );
+			if( res <= 0 )
+				exit( 1 );
+			got += (size_t)res;
+		}
+		samples[i] = bench_time_us() - start;
+	}
+	close( fd );
+}
+
+static void bench_small_post( unsigned short port, double* samples, int iterations )
+{
+	char url[64];
+	snprintf( url, sizeof( url ), "http://127.0.0.1:%u", port );
+
+	http_client_t c;
+	http_client_result res = http_client_connect( &c, url, 0x0, 0x0, 0 );
+	if( res != HTTP_CLIENT_OK )
+	{
+		fprintf( stderr, "%s\n", http_client_result_to_string( res ) );
+		exit( 1 );
+	}
+
+	for( int i = 0; i < iterations; ++i )
+	{
+		double start = bench_time_us();
+		res = http_client_post( c, "/post", "0123456789abcdef", 16 );
+		samples[i] = bench_time_us() - start;
+		if( res != HTTP_CLIENT_OK )
+		{
+			fprintf( stderr, "%s\n", http_client_result_to_string( res ) );
+			exit( 1 );
+		}
+	}
+
+	http_client_disconnect( c );
+	free( c );
+}
+
+static bool bench_check_head_and_delete( http_client_t c )
+{
+	size_t size;
+	return http_client_head( c, "/nolength/200", &size ) == HTTP_CLIENT_OK &&
+		   http_client_delete( c, "/nolength/204" ) == HTTP_CLIENT_OK &&
+		   http_client_head( c, "/nolength/200", &size ) == HTTP_CLIENT_OK &&
+		   http_client_get_into( c, "/fixed/64", bench_body, sizeof( bench_body ), &size ) == HTTP_CLIENT_OK;
+}
+
+static bool bench_check_pipeline( http_client_t c )
+{
+	// ... a response without body in the middle of the pipeline must not end it ...
+	http_client_pipeline_request requests[4] = {
+		{ "GET",  "/fixed/64",     0x0, 0, HTTP_CLIENT_OK },
+		{ "HEAD", "/nolength/200", 0x0, 0, HTTP_CLIENT_OK },
+		{ "HEAD", "/nolength/204", 0x0, 0, HTTP_CLIENT_OK },
+		{ "GET",  "/fixed/64",     0x0, 0, HTTP_CLIENT_OK },
+	};
+	bool ok = http_client_pipeline( c, requests, 4, 0x0 ) == HTTP_CLIENT_OK;
+	for( int i = 0; i < 4; ++i )
+		free( requests[i].msgbody );
+	return ok;
+}
+
+static bool bench_check_revalidate( http_client_t c )
+{
+	// ... a response with an ETag and no lifetime is revalidated on each GET ...
+	http_client_cache_t cache;
+	if( http_client_cache_create( &cache, 0x0 ) != HTTP_CLIENT_OK )
+		return false;
+	http_client_set_cache( c, cache );
+
+	char body[64];
+	size_t size;
+	bool ok = true;
+	for( int i = 0; i < 4 && ok; ++i )
+		ok = http_client_get_into( c, "/etag/64", body, sizeof( body ), &size ) == HTTP_CLIENT_OK && size == 64;
+
+	http_client_cache_stats stats;
+	http_client_cache_get_stats( cache, &stats );
+	http_client_set_cache( c, 0x0 );
+	http_client_cache_destroy( cache );
+	return ok && stats.revalidated == 3;
+}
+
+/**
+ * Run check on a new client and verify that the loopback server only got one connection for all its requests.
+ */
+static void bench_check_keep_alive( unsigned short port, const char* name, bool (*check)( http_client_t c ) )
+{
+	char url[64];
+	snprintf( url, sizeof( url ), "http://127.0.0.1:%u", port );
+
+	unsigned int accepted = __sync_fetch_and_add( &bench_server_accepted, 0 );
+	http_client_t c;
+	if( http_client_connect( &c, url, 0x0, 0x0, 0 ) != HTTP_CLIENT_OK )
+	{
+		fprintf( stderr, "failed to connect to loopback server\n" );
+		exit( 1 );
+	}
+
+	bool ok = check( c );
+	http_client_disconnect( c );
+	free( c );
+
+	unsigned int connections = __sync_fetch_and_add( &bench_server_accepted, 0 ) - accepted;
+	printf( "%-32s %s, %u connection(s)\n", name, ok && connections == 1 ? "ok" : "FAILED", connections );
+	if( !ok || connections != 1 )
+		exit( 1 );
+}
+
+/**
+ * Requests to benchmark, run on concurrency connections at once.
+ */
+struct bench_scenario
+{
+	const char* verb;
+	const char* kind;    ///< "fixed", "chunked" or "drip", see top of file.
+	size_t size;         ///< body size of the response, or of the request for POST.
+	int concurrency;
+};
+
+struct bench_worker
+{
+	const bench_scenario* scenario;
+	unsigned short port;
+	int iterations;
+	double* samples;
+	char* buffer;
+	pthread_barrier_t* start;
+	size_t bytes;        ///< body bytes received, or sent for POST.
+};
+
+static void* bench_worker_main( void* arg )
+{
+	bench_worker* w = (bench_worker*)arg;
+	const bench_scenario* scenario = w->scenario;
+
+	char url[64];
+	char path[64];
+	snprintf( url, sizeof( url ), "http://127.0.0.1:%u", w->port );
+	snprintf( path, sizeof( path ), "/%s/%zu", scenario->kind, scenario->size );
+
+	http_client_t c;
+	http_client_result res = http_client_connect( &c, url, 0x0, 0x0, 0 );
+	pthread_barrier_wait( w->start );
+	if( res != HTTP_CLIENT_OK )
+	{
+		fprintf( stderr, "%s\n", http_client_result_to_string( res ) );
+		exit( 1 );
+	}
+
+	for( int i = 0; i < w->iterations; ++i )
+	{
+		size_t size = 0;
+		double start = bench_time_us();
+		if( strcmp( scenario->verb, "GET" ) == 0 )
+			res = http_client_get_into( c, path, w->buffer, BENCH_MAX_BODY, &size );
+		else if( strcmp( scenario->verb, "HEAD" ) == 0 )
+			res = http_client_head( c, path, &size );
+		else
+			res = http_client_post( c, path, bench_body, size = scenario->size );
+		w->samples[i] = bench_time_us() - start;
+		if( res != HTTP_CLIENT_OK )
+		{
+			fprintf( stderr, "%s %s: %s\n", scenario->verb, path, http_client_result_to_string( res ) );
+			exit( 1 );
+		}
+		if( strcmp( scenario->verb, "HEAD" ) != 0 )
+			w->bytes += size;
+	}
+
+	http_client_disconnect( c );
+	free( c );
+	return 0x0;
+}
+
+static void bench_scenario_name( const bench_scenario* scenario, char* name, size_t name_size )
+{
+	char size[32];
+	if( scenario->size >= 1024 * 1024 && scenario->size % ( 1024 * 1024 ) == 0 )
+		snprintf( size, sizeof( size ), "%zuMB", scenario->size / ( 1024 * 1024 ) );
+	else if( scenario->size >= 1024 && scenario->size % 1024 == 0 )
+		snprintf( size, sizeof( size ), "%zuKB", scenario->size / 1024 );
+	else
+		snprintf( size, sizeof( size ), "%zuB", scenario->size );
+	snprintf( name, name_size, "%s %s %s c%d", scenario->verb, scenario->kind, size, scenario->concurrency );
+}
+
+static void bench_run_scenario( unsigned short port, const bench_scenario* scenario, int iterations )
+{
+	// ... keep large and slow bodies from taking forever ...
+	const size_t max_bytes = 64 * 1024 * 1024;
+	if( scenario->size > 0 && scenario->size * (size_t)iterations > max_bytes )
+		iterations = std::max( (int)( max_bytes / scenario->size ), 20 );
+	if( strcmp( scenario->kind, "drip" ) == 0 )
+		iterations = std::min( iterations, 20 );
+
+	int count = iterations * scenario->concurrency;
+	double* samples = (double*)malloc( sizeof( double ) * (size_t)count );
+	bench_worker* workers = (bench_worker*)malloc( sizeof( bench_worker ) * (size_t)scenario->concurrency );
+	pthread_t* threads = (pthread_t*)malloc( sizeof( pthread_t ) * (size_t)scenario->concurrency );
+
+	// ... all connections are made before the clock starts ...
+	pthread_barrier_t start;
+	pthread_barrier_init( &start, 0x0, (unsigned)scenario->concurrency + 1 );
+	for( int i = 0; i < scenario->concurrency; ++i )
+	{
+		bench_worker* w = &workers[i];
+		w->scenario   = scenario;
+		w->port       = port;
+		w->iterations = iterations;
+		w->samples    = samples + i * iterations;
+		w->buffer     = strcmp( scenario->verb, "GET" ) == 0 ? (char*)malloc( BENCH_MAX_BODY ) : 0x0;
+		w->start      = &start;
+		w->bytes      = 0;
+		pthread_create( &threads[i], 0x0, bench_worker_main, w );
+	}
+	pthread_barrier_wait( &start );
+	double begin = bench_time_us();
+
+	size_t bytes = 0;
+	for( int i = 0; i < scenario->concurrency; ++i )
+	{
+		pthread_join( threads[i], 0x0 );
+		bytes += workers[i].bytes;
+		free( workers[i].buffer );
+	}
+	double seconds = ( bench_time_us() - begin ) / 1000000.0;
+	pthread_barrier_destroy( &start );
+
+	std::sort( samples, samples + count );
+	char name[128];
+	bench_scenario_name( scenario, name, sizeof( name ) );
+	printf( "%-28s %10.0f req/s %9.1f MB/s  p50 %9.1fus  p99 %9.1fus  p999 %9.1fus\n",
+			name,
+			count / seconds,
+			(double)bytes / seconds / ( 1024.0 * 1024.0 ),
+			samples[count / 2],
+			samples[(int)( count * 0.99 )],
+			samples[(int)( count * 0.999 )] );
+	fflush( stdout );
+
+	free( threads );
+	free( workers );
+	free( samples );
+}
+
+static bool bench_match( const char* name, const char* filter )
+{
+	return filter == 0x0 || strstr( name, filter ) != 0x0;
+}
+
+int main( int argc, char** argv )
+{
+	int iterations = argc > 1 ? atoi( argv[1] ) : 1000;
+	const char* filter = argc > 2 ? argv[2] : 0x0;
+	if( iterations <= 0 )
+	{
+		printf( "usage: http_bench [iterations] [filter]\n" );
+		return 1;
+	}
+
+	for( size_t i = 0; i < sizeof( bench_body ); ++i )
+		bench_body[i] = (char)( 'a' + i % 26 );
+
+	unsigned short port = bench_start_server();
+	bench_check_keep_alive( port, "keep-alive, HEAD and 204", bench_check_head_and_delete );
+	bench_check_keep_alive( port, "keep-alive, pipeline", bench_check_pipeline );
+	bench_check_keep_alive( port, "keep-alive, 304 revalidation", bench_check_revalidate );
+
+	double* samples = (double*)malloc( sizeof( double ) * (size_t)iterations );
+
+	if( bench_match( "small POST, two sends + Nagle", filter ) )
+	{
+		bench_small_post_two_sends( port, samples, iterations );
+		bench_report( "small POST, two sends + Nagle", samples, iterations );
+	}
+
+	if( bench_match( "small POST, http_client_post", filter ) )
+	{
+		bench_small_post( port, samples, iterations );
+		bench_report( "small POST, http_client_post", samples, iterations );
+	}
+
+	free( samples );
+
+	static const size_t sizes[]       = { 64, 4096, 64 * 1024, 1024 * 1024 };
+	static const int    concurrency[] = { 1, 4, 16 };
+
+	bench_scenario scenarios[64];
+	int num_scenarios = 0;
+	for( size_t c = 0; c < sizeof( concurrency ) / sizeof( concurrency[0] ); ++c )
+	{
+		for( size_t s = 0; s < sizeof( sizes ) / sizeof( sizes[0] ); ++s )
+		{
+			bench_scenario get  = { "GET",  "fixed",   sizes[s], concurrency[c] };
+			bench_scenario post = { "POST", "fixed",   sizes[s], concurrency[c] };
+			scenarios[num_scenarios++] = get;
+			scenarios[num_scenarios++] = post;
+			if( sizes[s] >= 4096 )
+			{
+				bench_scenario chunked = { "GET", "chunked", sizes[s], concurrency[c] };
+				scenarios[num_scenarios++] = chunked;
+			}
+		}
+		bench_scenario head = { "HEAD", "fixed", 64, concurrency[c] };
+		bench_scenario drip = { "GET",  "drip",  16 * 1024, concurrency[c] };
+		scenarios[num_scenarios++] = head;
+		scenarios[num_scenarios++] = drip;
+	}
+
+	for( int i = 0; i < num_scenarios; ++i )
+	{
+		char name[128];
+		bench_scenario_name( &scenarios[i], name, sizeof( name ) );
+		if( bench_match( name, filter ) )
+			bench_run_scenario( port, &scenarios[i], iterations );
+	}
+
+	return 0;
+}
@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+#
+# Generate the perfect hash over well-known response header names used by http_client.
+#
+# Writes include/http_client/http_client_headers.h, the public enum of known headers, and
+# src/http_client_header_hash.inl, the hash table included by src/http_client_scan.cpp.
+# Re-run after changing HEADERS and commit the output.
+#
+# usage: tools/gen_header_hash.py
+
+import os
+import random
+import sys
+
+HEADERS = [
+	'Accept-Ranges',
+	'Access-Control-Allow-Credentials',
+	'Access-Control-Allow-Headers',
+	'Access-Control-Allow-Methods',
+	'Access-Control-Allow-Origin',
+	'Access-Control-Expose-Headers',
+	'Access-Control-Max-Age',
+	'Age',
+	'Allow',
+	'Alt-Svc',
+	'Cache-Control',
+	'Connection',
+	'Content-Disposition',
+	'Content-Encoding',
+	'Content-Language',
+	'Content-Length',
+	'Content-Location',
+	'Content-Range',
+	'Content-Security-Policy',
+	'Content-Type',
+	'Date',
+	'ETag',
+	'Expires',
+	'Keep-Alive',
+	'Last-Modified',
+	'Link',
+	'Location',
+	'Pragma',
+	'Proxy-Authenticate',
+	'Retry-After',
+	'Server',
+	'Set-Cookie',
+	'Strict-Transport-Security',
+	'Trailer',
+	'Transfer-Encoding',
+	'Upgrade',
+	'Vary',
+	'Via',
+	'Warning',
+	'WWW-Authenticate',
+	'X-Content-Type-Options',
+	'X-Frame-Options',
+]
+
+TABLE_SIZE = 128
+
+LICENSE = '''/*
+    Simple http-client written to be an drop-in code, focus is to be small
+    and easy to use but maybe not efficient.
+
+    version 1.0, June, 2014
+
+	Copyright (C) 2014- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+'''
+
+def fold( c ):
+	return ord( c ) | 0x20
+
+# characters of the name that are hashed, all known names are at least 3 characters.
+def hashed_chars( name ):
+	n = len( name )
+	return [ name[0], name[n // 2], name[n - 2], name[n - 1] ]
+
+def hash_name( name, m ):
+	h = len( name ) * m[0]
+	for c, mul in zip( hashed_chars( name ), m[1:] ):
+		h += fold( c ) * mul
+	return ( h & 0xffffffff ) % TABLE_SIZE
+
+def find_multipliers():
+	# ... deterministic search so that the output is stable between runs ...
+	rng = random.Random( 1 )
+	for _ in range( 1000000 ):
+		m = [ rng.randrange( 1, 256 ) for _ in range( 5 ) ]
+		if len( set( hash_name( h, m ) for h in HEADERS ) ) == len( HEADERS ):
+			return m
+	sys.exit( 'no perfect hash found, increase TABLE_SIZE' )
+
+def enum_name( name ):
+	return 'HTTP_CLIENT_HEADER_' + name.upper().replace( '-', '_' )
+
+def write_enum( path ):
+	with open( path, 'w' ) as f:
+		f.write( LICENSE )
+		f.write( '\n// generated by tools/gen_header_hash.py, do not edit.\n\n' )
+		f.write( '#ifndef HTTP_CLIENT_HEADERS_H_INCLUDED\n#define HTTP_CLIENT_HEADERS_H_INCLUDED\n\n' )
+		f.write( '/**\n * Well-known response headers, see http_client_get_header().\n */\n' )
+		f.write( 'enum http_client_header_id\n{\n' )
+		for name in HEADERS:
+			f.write( '\t%s,\n' % enum_name( name ) )
+		f.write( '\n\tHTTP_CLIENT_HEADER_KNOWN_COUNT,\n' )
+		f.write( '\tHTTP_CLIENT_HEADER_UNKNOWN = HTTP_CLIENT_HEADER_KNOWN_COUNT ///< header is not one of the known ones.\n' )
+		f.write( '};\n\n#endif // HTTP_CLIENT_HEADERS_H_INCLUDED\n' )
+
+def write_table( path, m ):
+	slots = [ None ] * TABLE_SIZE
+	for name in HEADERS:
+		slots[ hash_name( name, m ) ] = name
+
+	with open( path, 'w' ) as f:
+		f.write( LICENSE )
+		f.write( '\n// generated by tools/gen_header_hash.py, do not edit.\n\n' )
+		f.write( '#define HTTP_CLIENT_HEADER_MIN_NAME_LENGTH %d\n' % min( len( h ) for h in HEADERS ) )
+		f.write( '#define HTTP_CLIENT_HEADER_MAX_NAME_LENGTH %d\n\n' % max( len( h ) for h in HEADERS ) )
+		f.write( 'struct http_header_hash_entry\n{\n\tconst char*   name;   ///< lowercase name.\n\tunsigned char length; ///< length of name, 0 for an empty slot.\n\tunsigned char id;\n};\n\n' )
+		f.write( '/**\n * Slot of name in http_header_hash_table, length needs to be in [HTTP_CLIENT_HEADER_MIN_NAME_LENGTH, HTTP_CLIENT_HEADER_MAX_NAME_LENGTH].\n * Letters are folded to lowercase so the hash is case-insensitive.\n */\n' )
+		f.write( 'static inline unsigned int http_header_hash( const char* name, size_t length )\n{\n' )
+		f.write( '\tunsigned int h = (unsigned int)length * %du\n' % m[0] )
+		f.write( '\t               + ( (unsigned int)(unsigned char)name[0] | 0x20 ) * %du\n' % m[1] )
+		f.write( '\t               + ( (unsigned int)(unsigned char)name[length / 2] | 0x20 ) * %du\n' % m[2] )
+		f.write( '\t               + ( (unsigned int)(unsigned char)name[length - 2] | 0x20 ) * %du\n' % m[3] )
+		f.write( '\t               + ( (unsigned int)(unsigned char)name[length - 1] | 0x20 ) * %du;\n' % m[4] )
+		f.write( '\treturn h %% %du;\n}\n\n' % TABLE_SIZE )
+		f.write( 'static const http_header_hash_entry http_header_hash_table[%d] =\n{\n' % TABLE_SIZE )
+		for name in slots:
+			if name is None:
+				f.write( '\t{ 0x0, 0, 0 },\n' )
+			else:
+				f.write( '\t{ "%s", %d, %s },\n' % ( name.lower(), len( name ), enum_name( name ) ) )
+		f.write( '};\n' )
+
+root = os.path.join( os.path.dirname( os.path.abspath( __file__ ) ), '..' )
+m = find_multipliers()
+write_enum( os.path.join( root, 'include', 'http_client', 'http_client_headers.h' ) )
+write_table( os.path.join( root, 'src', 'http_client_header_hash.inl' ), m )